@@ -11,8 +11,8 @@ constexpr double M_PI = glm::pi<double>();
 #include <cstdio>
 #include <algorithm>
 
-#define STB_IMAGE_WRITE_IMPLEMENTATION
-#include "stb_image_write.h"
+#include "FieldSeries/FieldSeries.h"
+#include "FDTD/FDTD.h"
 
 // Physical constants
 const double c0 = 299792458.0;
@@ -41,30 +41,6 @@ double plane_wave_sine(int n, double dt) {
     return ramp * std::sin(omega * t);
 }
 
-// Save Ez field to PNG
-void save_png(const std::vector<std::vector<double>>& Ez,
-    int Nx, int Ny, int step)
-{
-    std::vector<unsigned char> img(Nx * Ny);
-
-    double maxv = 0.0;
-    for (int i = 0; i < Nx; ++i)
-        for (int j = 0; j < Ny; ++j)
-            maxv = std::max(maxv, std::abs(Ez[i][j]));
-    if (maxv == 0.0) maxv = 1.0;
-
-    for (int j = 0; j < Ny; ++j)
-        for (int i = 0; i < Nx; ++i) {
-            double v = Ez[i][j] / maxv;
-            v = 0.5 * (v + 1.0);
-            img[j * Nx + i] = (unsigned char)(255.0 * v);
-        }
-
-    char name[64];
-    std::snprintf(name, sizeof(name), "Ez_%04d.png", step);
-    stbi_write_png(name, Nx, Ny, 1, img.data(), Nx);
-}
-
 int main() {
     // Grid
     const int Nx = 400;
@@ -74,7 +50,7 @@ int main() {
 
     const double dx = 1e-3;
     const double dy = 1e-3;
-    const double dt = 1.0 / (c0 * std::sqrt(1.0 / (dx * dx) + 1.0 / (dy * dy)));
+    const double dt = FDTD::compute_stable_timestep(glm::vec3(dx, dy, dx), 2, 1.0f);
 
     // Fields
     std::vector<std::vector<double>> Ezx(Nx, std::vector<double>(Ny, 0.0));
@@ -111,6 +87,13 @@ int main() {
     // TF/SF boundary (right side)
     const int tf_x = Nx - pml - 2;
 
+    // Output
+    FieldSeriesWriter::Description output_description;
+    output_description.grid_resolution = glm::ivec3(Nx, Ny, 1);
+    output_description.time_per_frame = 10 * dt;
+    output_description.value_scale = 1.25f;    // unit amplitude plane wave with headroom, frames are encoded as they arrive
+    FieldSeriesWriter Ez_series("Ez.gzfs", output_description);
+
     // Time loop
     for (int n = 0; n < Nt; ++n) {
 
@@ -148,7 +131,7 @@ int main() {
 
         // Output
         if (n % 10 == 0)
-            save_png(Ez, Nx, Ny, n);
+            Ez_series.append_frame([&](glm::ivec3 id) { return (float)Ez[id.x][id.y]; });
     }
 
     return 0;
@@ -6,14 +6,15 @@ constexpr double M_PI = glm::pi<double>();
 #include <cmath>
 #include <cstdio>
 #include <algorithm>
+#include <complex>
 
 #define STB_IMAGE_WRITE_IMPLEMENTATION
 #include "stb_image_write.h"
 
-// ------------------ Constants ------------------
-constexpr double c0 = 299792458.0;
-constexpr double eps0 = 8.854187817e-12;
-constexpr double mu0 = 4.0 * M_PI * 1e-7;
+#include "FieldSeries/FieldSeries.h"
+#include "FDTD/FDTDCPU.h"
+#include "FDTD/SteadyStateMonitor.h"
+#include "FDTD/NearToFarField.h"
 
 // ------------------ PNG writer ------------------
 void save_png(const std::vector<std::vector<double>>& data,
@@ -46,35 +47,14 @@ int main()
     const int Ny = 800;
 
     const double dx = 2e-3;
-    const double dy = dx;
-    const double dt = dx / (2.2 * c0);
+    const double courant = 0.99;
 
-    const int Nt = 5000;
+    const int Nt = 5000; // upper bound, the steady state monitor stops earlier
 
     const double f0 = 2e9;
-    const double omega = 2.0 * M_PI * f0;
 
-    // -------- Fields --------
-    std::vector<std::vector<double>> Ez(Nx, std::vector<double>(Ny, 0.0));
-    std::vector<std::vector<double>> Hx(Nx, std::vector<double>(Ny, 0.0));
-    std::vector<std::vector<double>> Hy(Nx, std::vector<double>(Ny, 0.0));
-
-    std::vector<std::vector<double>> Ez2_sum(Nx, std::vector<double>(Ny, 0.0));
-    int Ez2_count = 0;
-
-    // -------- Simple PML damping --------
-    std::vector<double> damp_x(Nx, 1.0), damp_y(Ny, 1.0);
     const int pml = 40;
 
-    for (int i = 0; i < pml; ++i) {
-        double d = std::exp(-0.02 * (pml - i));
-        damp_x[i] = damp_x[Nx - 1 - i] = d;
-    }
-    for (int j = 0; j < pml; ++j) {
-        double d = std::exp(-0.02 * (pml - j));
-        damp_y[j] = damp_y[Ny - 1 - j] = d;
-    }
-
     // -------- Dual-slit PEC screen --------
     const int screen_x = 600;
     const int slit_width = 60;
@@ -83,65 +63,89 @@ int main()
     const int s1 = Ny / 2 - slit_sep / 2;
     const int s2 = Ny / 2 + slit_sep / 2;
 
-    std::vector<std::vector<bool>> isPEC(
-        Nx, std::vector<bool>(Ny, false));
+    // -------- Solver --------
+    // the screen and the plane wave are mirror symmetric about Ny / 2, only the upper half is simulated
+    FDTDCPU solver;
+    solver.symmetry_y = FDTD::EvenSymmetry;
+    solver.symmetry_plane = glm::ivec3(-1, Ny / 2, -1);
 
-    for (int j = 0; j < Ny; ++j) {
-        bool slit1 = std::abs(j - s1) <= slit_width / 2;
-        bool slit2 = std::abs(j - s2) <= slit_width / 2;
-        if (!(slit1 || slit2))
-            isPEC[screen_x][j] = true;
-    }
+    solver.initialzie_fields(
+        [&](glm::ivec3 id, FDTD::ElectroMagneticProperty& property) {
 
-    // -------- Main FDTD loop --------
-    for (int n = 0; n < Nt; ++n) {
-
-        // --- Update H ---
-        for (int i = 0; i < Nx - 1; ++i)
-            for (int j = 0; j < Ny - 1; ++j) {
-                Hx[i][j] -= (dt / mu0) *
-                    (Ez[i][j + 1] - Ez[i][j]) / dy;
-                Hy[i][j] += (dt / mu0) *
-                    (Ez[i + 1][j] - Ez[i][j]) / dx;
+            // periodic plane wave source (right -> left)
+            if (id.x == Nx - pml - 2) {
+                property.voxel_type = FDTD::SourceSinosoidalSoft;
+                property.source_frequency = f0;
+                property.source_amplitude = 1;
             }
 
-        // --- Update E ---
-        for (int i = 1; i < Nx - 1; ++i)
-            for (int j = 1; j < Ny - 1; ++j) {
-                if (isPEC[i][j]) {
-                    Ez[i][j] = 0.0;
-                }
-                else {
-                    Ez[i][j] += (dt / eps0) *
-                        ((Hy[i][j] - Hy[i - 1][j]) / dx -
-                            (Hx[i][j] - Hx[i][j - 1]) / dy);
-                }
-            }
+            bool slit1 = std::abs(id.y - s1) <= slit_width / 2;
+            bool slit2 = std::abs(id.y - s2) <= slit_width / 2;
+            if (id.x == screen_x && !(slit1 || slit2))
+                property.voxel_type = FDTD::PEC;
+        },
+        glm::ivec3(Nx, Ny, 1),
+        glm::ivec2(pml),
+        glm::ivec2(pml),
+        glm::ivec2(pml),
+        glm::vec3(dx),
+        courant
+    );
+
+    const double dt = solver.get_timestep();
 
-        // --- Periodic plane wave source (right -> left) ---
-        for (int j = 0; j < Ny; ++j)
-            Ez[Nx - pml - 2][j] += std::sin(omega * n * dt);
+    std::vector<std::vector<double>> Ez2_sum(Nx, std::vector<double>(Ny, 0.0));
+    int Ez2_count = 0;
+
+    // -------- Field output --------
+    // Ez peaks at about 2.8 times the source amplitude, a shared scale encodes every frame as it is appended.
+    // 8 bits keep the precision of the PNG frames the series replaces
+    FieldSeriesWriter::Description output_description;
+    output_description.grid_resolution = glm::ivec3(Nx, Ny, 1);
+    output_description.time_per_frame = 10 * dt;
+    output_description.value_scale = 4;
+    output_description.quantization_bits = 8;
+    FieldSeriesWriter Ez_series("Ez.gzfs", output_description);
+
+    // -------- Far field behind the screen --------
+    // the aperture line spans the grid into the absorbing layer, its currents radiate the transmitted field to x < screen_x
+    NearToFarField far_field(solver, { (float)f0 });
+    far_field.add_face(glm::ivec2(screen_x - 20, 0), glm::ivec2(screen_x - 20, Ny - 1), glm::ivec2(-1, 0));
+
+    // -------- Steady state monitor --------
+    SteadyStateMonitor monitor(SteadyStateMonitor::compute_period_ticks(f0, dt));
+    std::vector<float> samples;
+
+    // -------- Main FDTD loop --------
+    for (int n = 0; n < Nt && !monitor.is_converged(); ++n) {
+
+        solver.step();
 
-        // --- Apply damping ---
-        for (int i = 0; i < Nx; ++i)
-            for (int j = 0; j < Ny; ++j)
-                Ez[i][j] *= damp_x[i] * damp_y[j];
+        // --- Intensity accumulation (far field only, whole periods once settled) ---
+        samples.clear();
+        for (int j = pml; j < Ny - pml; j += 4)
+            samples.push_back(solver.get_electric_field(glm::ivec3(screen_x + 300, j, 0)));
 
-        // --- Intensity accumulation (far field only) ---
-        if (n > 2000) {
+        if (monitor.observe(samples) == SteadyStateMonitor::Accumulating) {
+            far_field.observe(solver);
             for (int i = screen_x + 300; i < Nx - pml; ++i)
-                for (int j = 0; j < Ny; ++j)
-                    Ez2_sum[i][j] += Ez[i][j] * Ez[i][j];
+                for (int j = 0; j < Ny; ++j) {
+                    double Ez = solver.get_electric_field(glm::ivec3(i, j, 0));
+                    Ez2_sum[i][j] += Ez * Ez;
+                }
             Ez2_count++;
         }
 
         if (n % 10 == 0)
-            save_png(Ez, Nx, Ny, std::string("Ez_") + std::to_string(n) + ".png");
+            Ez_series.append_frame([&](glm::ivec3 id) { return solver.get_electric_field(id); });
 
         if (n % 500 == 0)
             printf("Step %d / %d\n", n, Nt);
     }
 
+    printf("Accumulated %d ticks from step %d, stopped at step %d, %d of %d ticks saved\n",
+        Ez2_count, monitor.get_accumulation_begin_tick(), monitor.get_ticks_observed(), monitor.get_ticks_saved(Nt), Nt);
+
     // -------- Compute average intensity --------
     std::vector<std::vector<double>> I(Nx, std::vector<double>(Ny, 0.0));
 
@@ -153,5 +157,21 @@ int main()
     save_png(I, Nx, Ny, "intensity.png");
 
     printf("Saved intensity.png\n");
+
+    // -------- Far field pattern, angles from +x --------
+    std::vector<float> angles;
+    for (int i = 0; i <= 1800; ++i)
+        angles.push_back((float)(M_PI / 2 + M_PI * i / 1800));
+
+    std::vector<std::complex<double>> pattern =
+        far_field.compute_far_field_pattern(0, angles, glm::vec2((float)(screen_x * dx), (float)(Ny / 2 * dx)));
+
+    FILE* far_field_file = fopen("far_field.csv", "w");
+    fprintf(far_field_file, "angle_deg,intensity_w_per_rad\n");
+    for (size_t i = 0; i < angles.size(); ++i)
+        fprintf(far_field_file, "%f,%g\n", angles[i] * 180.0 / M_PI, NearToFarField::compute_radiation_intensity(pattern[i]));
+    fclose(far_field_file);
+
+    printf("Saved far_field.csv\n");
     return 0;
 }
@@ -1,6 +1,8 @@
 #include "Gozdiscoptics.h"
 #include "FDTD/FDTD.h"
 
+#include <algorithm>
+
 void point_source(FDTD::ElectroMagneticProperty& property, glm::ivec3 id, glm::ivec3 light_position, float frequency, float amplitude) {
 	if (id == light_position) {
 		property.voxel_type = FDTD::SourceSinosoidal;
@@ -29,18 +31,41 @@ void main() {
 
 	FDTD solver;
 
+	// 2 mm cells around the slit screen and the slits, graded up to 6 mm (a tenth of the wavelength) in free space.
+	// the renderer maps the screen through the node positions so the picture keeps its physical proportions
+	const float fine_spacing = 2e-3f;
+	const float coarse_spacing = 6e-3f;
+
+	solver.graded_spacing_x = FDTD::compute_graded_spacing(2.048f, fine_spacing, coarse_spacing, { glm::vec2(0.78f, 0.83f) });
+
+	// the slits mirror about the plane, only the cells above it are simulated and the mesh below is its mirror image
+	std::vector<float> upper_spacing_y = FDTD::compute_graded_spacing(1.024f, fine_spacing, coarse_spacing, { glm::vec2(0.0f, 0.14f) });
+	solver.graded_spacing_y.assign(upper_spacing_y.rbegin(), upper_spacing_y.rend());
+	solver.graded_spacing_y.insert(solver.graded_spacing_y.end(), upper_spacing_y.begin(), upper_spacing_y.end());
+
+	solver.symmetry_y = FDTD::EvenSymmetry;
+	solver.symmetry_plane = glm::ivec3(-1, (int32_t)upper_spacing_y.size(), -1);
+
+	std::vector<float> position_x = FDTD::compute_node_positions(solver.graded_spacing_x);
+	std::vector<float> position_y = FDTD::compute_node_positions(solver.graded_spacing_y);
+	const float plane_y = position_y[upper_spacing_y.size()];
+	const int32_t source_x = (int32_t)(std::lower_bound(position_x.begin(), position_x.end(), 0.2f) - position_x.begin());
+
 	solver.initialzie_fields(
 		[&](glm::ivec3 id, FDTD::ElectroMagneticProperty& property) {
 			
-			//point_source(property, id, glm::ivec3(512, 512, 0), 2.0 * glm::pi<float>() * 2e9, 0.02);
-			plane_wave_source(property, id, glm::ivec3(100, 0, 0), glm::ivec3(1, 1024, 1), glm::pi<float>() * 1e10, 0.4);
+			float x = position_x[id.x];
+			float y = std::abs(position_y[id.y] - plane_y);
+
+			//point_source(property, id, glm::ivec3(solver.graded_spacing_x.size() / 2, upper_spacing_y.size(), 0), 2e9, 0.02);
+			plane_wave_source(property, id, glm::ivec3(source_x, 0, 0), glm::ivec3(1, solver.graded_spacing_y.size(), 1), 5e9, 0.4);
 
-			if (in_range(id.x, 400, 404) && !(in_range(id.y, 440, 490) || in_range(id.y, 510, 560)))
+			if (in_range(x, 0.8f, 0.808f) && !in_range(y, 0.02f, 0.12f))
 				property.voxel_type = FDTD::PEC;
 
 
 		},
-		glm::ivec3(1024, 1024, 1),
+		glm::ivec3(solver.graded_spacing_x.size(), solver.graded_spacing_y.size(), 1),
 		glm::ivec2(40),
 		glm::ivec2(40)
 	);
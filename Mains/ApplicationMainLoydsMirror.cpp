@@ -10,6 +10,10 @@ constexpr double M_PI = glm::pi<double>();
 #define STB_IMAGE_WRITE_IMPLEMENTATION
 #include "stb_image_write.h"
 
+#include "FieldSeries/FieldSeries.h"
+#include "FDTD/FDTD.h"
+#include "FDTD/SteadyStateMonitor.h"
+
 // ------------------ Constants ------------------
 constexpr double c0 = 299792458.0;
 constexpr double eps0 = 8.854187817e-12;
@@ -46,9 +50,10 @@ int main()
 
     const double dx = 2e-3;
     const double dy = dx;
-    const double dt = dx / (2.2 * c0);
+    const double courant = 0.99;
+    const double dt = FDTD::compute_stable_timestep(glm::vec3(dx, dy, dx), 2, courant);
 
-    const int Nt = 5000;
+    const int Nt = 5000; // upper bound, the steady state monitor stops earlier
 
     const double f0 = 2e9;
     const double omega = 2.0 * M_PI * f0;
@@ -87,8 +92,22 @@ int main()
     // -------- Plane wave injection line --------
     const int src_x = 100;
 
+    // -------- Field output --------
+    // Ez peaks at about 2.1 times the source amplitude, a shared scale encodes every frame as it is appended.
+    // 8 bits keep the precision of the PNG frames the series replaces
+    FieldSeriesWriter::Description output_description;
+    output_description.grid_resolution = glm::ivec3(Nx, Ny, 1);
+    output_description.time_per_frame = 10 * dt;
+    output_description.value_scale = 4;
+    output_description.quantization_bits = 8;
+    FieldSeriesWriter Ez_series("Ez.gzfs", output_description);
+
+    // -------- Steady state monitor --------
+    SteadyStateMonitor monitor(SteadyStateMonitor::compute_period_ticks(f0, dt));
+    std::vector<float> samples;
+
     // -------- Main FDTD loop --------
-    for (int n = 0; n < Nt; ++n) {
+    for (int n = 0; n < Nt && !monitor.is_converged(); ++n) {
 
         // --- Update H ---
         for (int i = 0; i < Nx - 1; ++i)
@@ -124,8 +143,12 @@ int main()
             for (int j = 0; j < Ny; ++j)
                 Ez[i][j] *= damp_x[i] * damp_y[j];
 
-        // --- Intensity accumulation ---
-        if (n > 2500) {
+        // --- Intensity accumulation (whole periods once settled) ---
+        samples.clear();
+        for (int j = mirror_y + 50; j < Ny - pml; j += 4)
+            samples.push_back((float)Ez[src_x + 300][j]);
+
+        if (monitor.observe(samples) == SteadyStateMonitor::Accumulating) {
             for (int i = src_x + 300; i < Nx - pml; ++i)
                 for (int j = mirror_y + 50; j < Ny - pml; ++j)
                     Ez2_sum[i][j] += Ez[i][j] * Ez[i][j];
@@ -133,12 +156,15 @@ int main()
         }
 
         if (n % 10 == 0)
-            save_png(Ez, Nx, Ny, std::string("Ez_") + std::to_string(n) + ".png");
+            Ez_series.append_frame([&](glm::ivec3 id) { return (float)Ez[id.x][id.y]; });
 
         if (n % 500 == 0)
             printf("Step %d / %d\n", n, Nt);
     }
 
+    printf("Accumulated %d ticks from step %d, stopped at step %d, %d of %d ticks saved\n",
+        Ez2_count, monitor.get_accumulation_begin_tick(), monitor.get_ticks_observed(), monitor.get_ticks_saved(Nt), Nt);
+
     // -------- Final intensity --------
     std::vector<std::vector<double>> I(Nx, std::vector<double>(Ny, 0.0));
 
@@ -0,0 +1,1494 @@
+#include "gtc/constants.hpp"
+#include <string>
+constexpr double M_PI = glm::pi<double>();
+
+#include <vector>
+#include <cmath>
+#include <cstdio>
+#include <chrono>
+#include <algorithm>
+#include <functional>
+#include <complex>
+#include <memory>
+#include <cstring>
+#include <cstdlib>
+#include <fstream>
+
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include "stb_image_write.h"
+
+#include "FDTD/FDTDCPU.h"
+#include "FDTD/FDTDAutotuner.h"
+#include "FDTD/NearToFarField.h"
+#include "FDTD/ProbeRecorder.h"
+#include "FDTD/SteadyStateMonitor.h"
+#include "FieldSeries/FieldSeries.h"
+
+// ------------------ Golden scenes ------------------
+// Reduced double slit, Lloyd's mirror, free space point source, a
+// Bloch periodic plane wave and periodic standing waves for the dispersion
+// of the second and fourth order stencils. The near to far field transform
+// is checked against probes in the grid and the pattern of a source pair.
+// Warm starts with patched properties are checked against cold starts,
+// probe signals read back from disk against direct samples of the fields.
+// Field series decode back within half a quantization step and a
+// double slit series is smaller than its frames written as PNGs.
+// Graded meshes are checked for exactness on uniform spacing, the fringes
+// of a graded double slit and the reflection off the grading.
+// Physics is checked against analytic predictions, every optimized
+// kernel variant is diffed against the reference kernels.
+//
+// The default tier takes about ten seconds on one core, the equivalence
+// checks run on fewer ticks and scenes. --slow adds the full variant and ensemble
+// matrices, the ensemble and probe benchmarks, the graded mesh sweeps and
+// the warm starts that run to steady state.
+
+constexpr double c0 = 299792458.0;
+constexpr double eps0 = 8.854187817e-12;
+constexpr double mu0 = 4.0 * M_PI * 1e-7;
+
+// relative to the peak |Ez| of the reference run
+constexpr double float_variant_tolerance = 1e-4;
+constexpr double float_to_double_tolerance = 1e-3;
+
+const std::vector<FDTDCPU::KernelVariant> optimized_variants = {
+    FDTDCPU::Vectorized,
+    FDTDCPU::Tiled,
+};
+
+const char* variant_name(FDTDCPU::KernelVariant variant) {
+    switch (variant) {
+    case FDTDCPU::Reference:    return "reference";
+    case FDTDCPU::Vectorized:   return "vectorized";
+    case FDTDCPU::Tiled:        return "tiled";
+    }
+    return "unknown";
+}
+
+int failure_count = 0;
+
+void check(const std::string& name, double measured, double expected, double tolerance) {
+    bool pass = std::abs(measured - expected) <= tolerance;
+    if (!pass) failure_count++;
+    printf("[%s] %-48s measured %12.5g expected %12.5g tolerance %10.3g\n",
+        pass ? "PASS" : "FAIL", name.c_str(), measured, expected, tolerance);
+}
+
+struct Scene {
+    std::string name;
+    std::function<void(glm::ivec3, FDTD::ElectroMagneticProperty&)> initialization;
+    glm::ivec3 resolution;
+    int pml;
+    FDTD::BoundaryCondition boundary_x = FDTD::Absorbing;
+    FDTD::BoundaryCondition boundary_y = FDTD::Absorbing;
+    glm::vec3 bloch_wavevector = glm::vec3(0);
+    FDTD::Symmetry symmetry_x = FDTD::NoSymmetry;
+    FDTD::Symmetry symmetry_y = FDTD::NoSymmetry;
+    int spatial_order = 2;
+    std::vector<float> graded_spacing_x;
+    std::vector<float> graded_spacing_y;
+    glm::ivec2 tile_size = glm::ivec2(0, 16);
+    int thread_count = 0;
+};
+
+struct SceneResult {
+    std::vector<float> Ez;
+    std::vector<float> Ez_imaginary;
+    std::vector<double> Ez2_mean;
+    std::vector<double> energy;
+    FieldState state;
+    int ticks_to_steady = 0;
+};
+
+// runs the scene for Nt ticks, time averages Ez^2 over the last accumulate ticks
+// Ez is unfolded to the full grid, Ez2_mean and energy cover the simulated cells
+SceneResult run_scene(const Scene& scene, FDTDCPU::KernelVariant variant, int Nt, int accumulate, bool track_energy) {
+
+    FDTDCPU solver;
+    solver.kernel_variant = variant;
+    solver.boundary_condition_x = scene.boundary_x;
+    solver.boundary_condition_y = scene.boundary_y;
+    solver.bloch_wavevector = scene.bloch_wavevector;
+    solver.symmetry_x = scene.symmetry_x;
+    solver.symmetry_y = scene.symmetry_y;
+    solver.spatial_order = scene.spatial_order;
+    solver.graded_spacing_x = scene.graded_spacing_x;
+    solver.graded_spacing_y = scene.graded_spacing_y;
+    solver.tile_size = scene.tile_size;
+    solver.thread_count = scene.thread_count;
+    solver.initialzie_fields(scene.initialization, scene.resolution, glm::ivec2(scene.pml), glm::ivec2(scene.pml));
+
+    size_t cell_count = solver.electric_field.size();
+
+    SceneResult result;
+    result.Ez2_mean.assign(cell_count, 0.0);
+
+    for (int n = 0; n < Nt; ++n) {
+        solver.step();
+
+        if (n >= Nt - accumulate)
+            for (size_t i = 0; i < cell_count; ++i)
+                result.Ez2_mean[i] += (double)solver.electric_field[i] * solver.electric_field[i] / accumulate;
+
+        if (track_energy) {
+            double energy = 0.0;
+            for (size_t i = 0; i < cell_count; ++i)
+                energy += eps0 * solver.electric_field[i] * solver.electric_field[i] +
+                    mu0 * (solver.magnetic_field_x[i] * solver.magnetic_field_x[i] + solver.magnetic_field_y[i] * solver.magnetic_field_y[i]);
+            result.energy.push_back(energy);
+        }
+    }
+
+    result.Ez = solver.get_unfolded_electric_field();
+    result.Ez_imaginary = solver.electric_field_imaginary;
+    return result;
+}
+
+// runs until Ez^2 on the observation column settles, time averages Ez^2 over the accumulated periods
+// warm_start continues from the settled fields of a neighbouring scene instead of zero fields
+SceneResult run_scene_until_steady(const Scene& scene, FDTDCPU::KernelVariant variant, int max_ticks, float period_ticks, int observation_x, const FieldState* warm_start = nullptr) {
+
+    FDTDCPU solver;
+    solver.kernel_variant = variant;
+    solver.boundary_condition_x = scene.boundary_x;
+    solver.boundary_condition_y = scene.boundary_y;
+    solver.bloch_wavevector = scene.bloch_wavevector;
+    solver.symmetry_x = scene.symmetry_x;
+    solver.symmetry_y = scene.symmetry_y;
+    solver.spatial_order = scene.spatial_order;
+    solver.graded_spacing_x = scene.graded_spacing_x;
+    solver.graded_spacing_y = scene.graded_spacing_y;
+    solver.tile_size = scene.tile_size;
+    solver.thread_count = scene.thread_count;
+    solver.initialzie_fields(scene.initialization, scene.resolution, glm::ivec2(scene.pml), glm::ivec2(scene.pml));
+
+    if (warm_start != nullptr)
+        solver.load_field_state(*warm_start);
+
+    size_t cell_count = solver.electric_field.size();
+
+    SceneResult result;
+    result.Ez2_mean.assign(cell_count, 0.0);
+
+    SteadyStateMonitor monitor(period_ticks);
+    std::vector<float> samples;
+
+    for (int n = 0; n < max_ticks && !monitor.is_converged(); ++n) {
+        solver.step();
+
+        samples.clear();
+        for (int j = scene.pml; j < scene.resolution.y - scene.pml; j += 2)
+            samples.push_back(solver.electric_field[solver.get_index(glm::ivec3(observation_x, j, 0))]);
+
+        if (monitor.observe(samples) == SteadyStateMonitor::Accumulating)
+            for (size_t i = 0; i < cell_count; ++i)
+                result.Ez2_mean[i] += (double)solver.electric_field[i] * solver.electric_field[i];
+    }
+
+    for (size_t i = 0; i < cell_count; ++i)
+        result.Ez2_mean[i] /= std::max(1, monitor.get_accumulated_tick_count());
+
+    printf("[INFO] %-48s accumulation from tick %d, stopped at %d, %d of %d ticks saved\n",
+        scene.name.c_str(), monitor.get_accumulation_begin_tick(), monitor.get_ticks_observed(), monitor.get_ticks_saved(max_ticks), max_ticks);
+
+    if (!monitor.is_converged()) {
+        printf("[FAIL] %s did not reach steady state\n", scene.name.c_str());
+        failure_count++;
+    }
+
+    result.Ez = solver.get_unfolded_electric_field();
+    result.Ez_imaginary = solver.electric_field_imaginary;
+    result.state = solver.get_field_state();
+    result.ticks_to_steady = monitor.get_ticks_observed();
+    return result;
+}
+
+double relative_difference(const std::vector<float>& a, const std::vector<float>& b) {
+    double max_difference = 0.0;
+    double max_value = 0.0;
+    for (size_t i = 0; i < a.size(); ++i) {
+        max_difference = std::max(max_difference, (double)std::abs(a[i] - b[i]));
+        max_value = std::max(max_value, (double)std::abs(a[i]));
+    }
+    return max_difference / std::max(max_value, 1e-30);
+}
+
+// local extremum of column data near guess, refined with a parabola
+double find_extremum(const std::vector<double>& data, double guess, int search_radius, bool maximum) {
+    int best = (int)std::round(guess);
+    for (int j = (int)std::round(guess) - search_radius; j <= (int)std::round(guess) + search_radius; ++j) {
+        if (j < 1 || j >= (int)data.size() - 1) continue;
+        if (maximum ? data[j] > data[best] : data[j] < data[best]) best = j;
+    }
+    double left = data[best - 1], center = data[best], right = data[best + 1];
+    double denominator = left - 2.0 * center + right;
+    return best + (denominator != 0.0 ? 0.5 * (left - right) / denominator : 0.0);
+}
+
+std::vector<double> column(const std::vector<double>& data, glm::ivec3 resolution, int x) {
+    std::vector<double> result(resolution.y);
+    for (int j = 0; j < resolution.y; ++j)
+        result[j] = data[(size_t)j * resolution.x + x];
+    return result;
+}
+
+// ------------------ Main ------------------
+// standing wave along x in a fully periodic strip, returns the numerical phase velocity error w / (c k) - 1
+// measured from the zero crossings of Ez, predicted holds the error of the discrete dispersion relation
+double measure_standing_wave_dispersion(int spatial_order, int cells_per_wavelength, double& predicted) {
+
+    const int Nx = 2 * cells_per_wavelength;
+    const int Nt = 4000;
+
+    FDTDCPU solver;
+    solver.boundary_condition_x = FDTD::Periodic;
+    solver.boundary_condition_y = FDTD::Periodic;
+    solver.spatial_order = spatial_order;
+    solver.initialzie_fields([](glm::ivec3, FDTD::ElectroMagneticProperty&) {}, glm::ivec3(Nx, 4, 1), glm::ivec2(1), glm::ivec2(1));
+
+    const double dx = solver.get_grid_spacing().x;
+    const double dt = solver.get_timestep();
+    const double kd = 2.0 * M_PI / cells_per_wavelength;
+
+    for (int j = 0; j < 4; ++j)
+        for (int i = 0; i < Nx; ++i)
+            solver.electric_field[solver.get_index(glm::ivec3(i, j, 0))] = std::cos(kd * i);
+
+    double previous = solver.electric_field[0];
+    double first_crossing = -1, last_crossing = -1;
+    int crossing_count = 0;
+
+    for (int n = 1; n <= Nt; ++n) {
+        solver.step();
+
+        double current = solver.electric_field[0];
+        if ((previous < 0) != (current < 0)) {
+            double crossing = n - 1 + previous / (previous - current);
+            if (crossing_count == 0) first_crossing = crossing;
+            last_crossing = crossing;
+            crossing_count++;
+        }
+        previous = current;
+    }
+
+    // sin(w dt / 2) / (c dt) = |D(k)| with D the derivative of the stencil applied to exp(i k x)
+    double derivative = spatial_order == 4 ?
+        (9.0 / 8.0 * std::sin(kd / 2) - 1.0 / 24.0 * std::sin(3.0 * kd / 2)) * 2.0 / dx :
+        std::sin(kd / 2) * 2.0 / dx;
+    double predicted_omega = 2.0 / dt * std::asin(c0 * dt * derivative / 2.0);
+    predicted = predicted_omega * dx / (c0 * kd) - 1.0;
+
+    double measured_omega = M_PI * (crossing_count - 1) / ((last_crossing - first_crossing) * dt);
+    return measured_omega * dx / (c0 * kd) - 1.0;
+}
+
+int main(int argc, char** argv)
+{
+    auto begin = std::chrono::steady_clock::now();
+
+    const bool slow_tier = argc > 1 && std::strcmp(argv[1], "--slow") == 0;
+
+    // ticks of the runs diffed against each other, 100 already carry the double slit's wave through the slits
+    const int equivalence_ticks = slow_tier ? 300 : 100;
+
+    // kernels the symmetric and graded scenes are checked with, the optimized ones are diffed against the reference separately
+    const std::vector<FDTDCPU::KernelVariant> equivalence_variants = slow_tier ?
+        std::vector<FDTDCPU::KernelVariant>{ FDTDCPU::Reference, FDTDCPU::Vectorized } :
+        std::vector<FDTDCPU::KernelVariant>{ FDTDCPU::Vectorized };
+
+    FDTDCPU probe;
+    probe.initialzie_fields([](glm::ivec3, FDTD::ElectroMagneticProperty&) {}, glm::ivec3(4, 4, 1), glm::ivec2(1), glm::ivec2(1));
+    const double dx = probe.get_grid_spacing().x;
+    const double dt = probe.get_timestep();
+
+    const double lambda_cells = 20.0;
+    const double lambda = lambda_cells * dx;
+    const double frequency = c0 / lambda;
+    const float period_ticks = SteadyStateMonitor::compute_period_ticks(frequency, dt);
+
+    // -------- Double slit --------
+    const int slit_screen_x = 110;
+    const int slit_half_width = 3;
+    const int slit_sep = 60;
+
+    Scene double_slit;
+    double_slit.name = "double slit";
+    double_slit.resolution = glm::ivec3(420, 320, 1);
+    double_slit.pml = 60;
+    double_slit.initialization = [&](glm::ivec3 id, FDTD::ElectroMagneticProperty& property) {
+        int center_y = double_slit.resolution.y / 2;
+        if (id.x == slit_screen_x - 40) {
+            property.voxel_type = FDTD::SourceSinosoidalSoft;
+            property.source_frequency = frequency;
+            property.source_amplitude = 1;
+        }
+        bool slit1 = std::abs(id.y - (center_y - slit_sep / 2)) <= slit_half_width;
+        bool slit2 = std::abs(id.y - (center_y + slit_sep / 2)) <= slit_half_width;
+        if ((id.x == slit_screen_x || id.x == slit_screen_x + 1) && !(slit1 || slit2))
+            property.voxel_type = FDTD::PEC;
+    };
+
+    // -------- Lloyd's mirror --------
+    const int mirror_y = 40;
+    const int mirror_src_x = 40;
+    const double theta = 20.0 * M_PI / 180.0;
+    const double ky = 2.0 * M_PI / lambda * std::sin(theta);
+
+    Scene lloyds_mirror;
+    lloyds_mirror.name = "lloyd's mirror";
+    lloyds_mirror.resolution = glm::ivec3(330, 220, 1);
+    lloyds_mirror.pml = 30;
+    lloyds_mirror.initialization = [&](glm::ivec3 id, FDTD::ElectroMagneticProperty& property) {
+        if (id.y == mirror_y)
+            property.voxel_type = FDTD::PEC;
+        else if (id.x == mirror_src_x && id.y > mirror_y && id.y < lloyds_mirror.resolution.y - lloyds_mirror.pml) {
+            // phase grows with height so the wave travels down towards the mirror
+            property.voxel_type = FDTD::SourceSinosoidalSoft;
+            property.source_frequency = frequency;
+            property.source_amplitude = 1;
+            property.source_phase = ky * (id.y - mirror_y) * dx;
+        }
+    };
+
+    // -------- Free space point source --------
+    Scene point_source;
+    point_source.name = "point source";
+    point_source.resolution = glm::ivec3(200, 200, 1);
+    point_source.pml = 30;
+    point_source.initialization = [&](glm::ivec3 id, FDTD::ElectroMagneticProperty& property) {
+        if (id.x == point_source.resolution.x / 2 && id.y == point_source.resolution.y / 2)
+            property.voxel_type = FDTD::SourceImpulse;
+    };
+
+    // -------- Bloch periodic plane wave --------
+    // one period tall strip, periodic in y with the phase shift of an oblique plane wave
+    const double bloch_theta = 30.0 * M_PI / 180.0;
+    const double bloch_ky = 2.0 * M_PI / lambda * std::sin(bloch_theta);
+    const int bloch_src_x = 80;
+
+    Scene bloch_plane_wave;
+    bloch_plane_wave.name = "bloch plane wave";
+    bloch_plane_wave.resolution = glm::ivec3(320, 24, 1);
+    bloch_plane_wave.pml = 60;
+    bloch_plane_wave.boundary_y = FDTD::BlochPeriodic;
+    bloch_plane_wave.bloch_wavevector = glm::vec3(0, bloch_ky, 0);
+    bloch_plane_wave.initialization = [&](glm::ivec3 id, FDTD::ElectroMagneticProperty& property) {
+        if (id.x == bloch_src_x) {
+            property.voxel_type = FDTD::SourceSinosoidalSoft;
+            property.source_frequency = frequency;
+            property.source_amplitude = 1.0f;
+            property.source_phase = -bloch_ky * id.y * dx;
+        }
+    };
+
+    // -------- Symmetry planes --------
+    // odd row counts put the plane on the middle row so the full domain is exactly symmetric
+    Scene even_symmetric_slit = double_slit;
+    even_symmetric_slit.name = "double slit, even y plane";
+    even_symmetric_slit.resolution.y = double_slit.resolution.y + 1;
+
+    Scene antisymmetric_pair;
+    antisymmetric_pair.name = "antisymmetric pair";
+    antisymmetric_pair.resolution = glm::ivec3(201, 201, 1);
+    antisymmetric_pair.pml = 30;
+    antisymmetric_pair.initialization = [&](glm::ivec3 id, FDTD::ElectroMagneticProperty& property) {
+        if (id.x == 100 && (id.y == 70 || id.y == 130)) {
+            property.voxel_type = FDTD::SourceSinosoidalSoft;
+            property.source_frequency = frequency;
+            property.source_amplitude = 1;
+            property.source_phase = id.y < 100 ? 0.0f : (float)M_PI;
+        }
+    };
+
+    Scene quartered_pair = antisymmetric_pair;
+    quartered_pair.name = "antisymmetric pair, even x odd y planes";
+    quartered_pair.symmetry_x = FDTD::EvenSymmetry;
+    quartered_pair.symmetry_y = FDTD::OddSymmetry;
+
+    Scene halved_slit = even_symmetric_slit;
+    halved_slit.symmetry_y = FDTD::EvenSymmetry;
+
+    // -------- Neighbouring double slits for warm starts --------
+    Scene wide_double_slit = double_slit;
+    wide_double_slit.name = "double slit, one cell wider slits";
+    wide_double_slit.initialization = [&](glm::ivec3 id, FDTD::ElectroMagneticProperty& property) {
+        double_slit.initialization(id, property);
+        int center_y = double_slit.resolution.y / 2;
+        bool edge1 = std::abs(id.y - (center_y - slit_sep / 2)) == slit_half_width + 1;
+        bool edge2 = std::abs(id.y - (center_y + slit_sep / 2)) == slit_half_width + 1;
+        if ((id.x == slit_screen_x || id.x == slit_screen_x + 1) && (edge1 || edge2))
+            property.voxel_type = FDTD::Normal;
+    };
+
+    Scene hard_source_double_slit = double_slit;
+    hard_source_double_slit.name = "double slit, hard source";
+    hard_source_double_slit.initialization = [&](glm::ivec3 id, FDTD::ElectroMagneticProperty& property) {
+        double_slit.initialization(id, property);
+        if (property.voxel_type == FDTD::SourceSinosoidalSoft) {
+            property.voxel_type = FDTD::SourceSinosoidal;
+            property.source_amplitude = 0.5f;
+        }
+    };
+
+    // -------- Double slit: fringe positions --------
+    FieldState settled_double_slit;
+    {
+        // close enough that reflections of the absorbing layer stay small next to the slit waves
+        const int observation_x = slit_screen_x + 1 + 80;
+
+        const int max_ticks = 3000;
+        SceneResult result = run_scene_until_steady(double_slit, FDTDCPU::Vectorized, max_ticks, period_ticks, observation_x);
+        settled_double_slit = result.state;
+
+        const double L = observation_x - (slit_screen_x + 1);
+        const double center_y = double_slit.resolution.y / 2;
+        std::vector<double> intensity = column(result.Ez2_mean, double_slit.resolution, observation_x);
+
+        // Huygens sum over the aperture cells with the asymptotic 2D kernel and obliquity factor
+        const double k = 2.0 * M_PI / lambda_cells;
+        auto predicted_intensity = [&](double y) {
+            double re = 0.0, im = 0.0;
+            for (int slit : { (int)center_y - slit_sep / 2, (int)center_y + slit_sep / 2 })
+                for (int ya = slit - slit_half_width; ya <= slit + slit_half_width; ++ya) {
+                    double r = std::hypot(L, y - ya);
+                    double amplitude = 0.5 * (1.0 + L / r) / std::sqrt(r);
+                    re += amplitude * std::cos(k * r);
+                    im -= amplitude * std::sin(k * r);
+                }
+            return re * re + im * im;
+        };
+
+        // point slits: path difference r1 - r2 = m * lambda gives the starting guess
+        auto predicted_y = [&](double m, bool maximum) {
+            double low = center_y, high = center_y + 200.0;
+            for (int i = 0; i < 60; ++i) {
+                double y = 0.5 * (low + high);
+                double r1 = std::hypot(L, y - (center_y - slit_sep / 2));
+                double r2 = std::hypot(L, y - (center_y + slit_sep / 2));
+                ((r1 - r2) < m * lambda_cells ? low : high) = y;
+            }
+            double best = 0.5 * (low + high);
+            for (double y = best - 10.0; y <= best + 10.0; y += 0.01)
+                if (maximum ? predicted_intensity(y) > predicted_intensity(best) : predicted_intensity(y) < predicted_intensity(best))
+                    best = y;
+            return best;
+        };
+
+        double maximum_0 = find_extremum(intensity, center_y, 6, true);
+        double maximum_p1 = find_extremum(intensity, predicted_y(1.0, true), 8, true);
+        double maximum_n1 = find_extremum(intensity, 2.0 * center_y - predicted_y(1.0, true), 8, true);
+        double minimum_p = find_extremum(intensity, predicted_y(0.5, false), 6, false);
+        double minimum_p2 = find_extremum(intensity, predicted_y(1.5, false), 6, false);
+
+        check("double slit central maximum [cells]", maximum_0, center_y, 1.0);
+        check("double slit first order maximum +1 [cells]", maximum_p1, predicted_y(1.0, true), 2.0);
+        check("double slit first order maximum -1 [cells]", maximum_n1, 2.0 * center_y - predicted_y(1.0, true), 2.0);
+        check("double slit first minimum [cells]", minimum_p, predicted_y(0.5, false), 1.5);
+        check("double slit second minimum [cells]", minimum_p2, predicted_y(1.5, false), 1.5);
+        check("double slit fringe spacing [cells]", 0.5 * (maximum_p1 - maximum_n1), predicted_y(1.0, true) - center_y, 1.5);
+    }
+
+    // -------- Lloyd's mirror: fringe spacing above the mirror --------
+    {
+        const int observation_x = mirror_src_x + 200;
+
+        const int max_ticks = 3000;
+        SceneResult result = run_scene_until_steady(lloyds_mirror, FDTDCPU::Vectorized, max_ticks, period_ticks, observation_x);
+
+        std::vector<double> intensity = column(result.Ez2_mean, lloyds_mirror.resolution, observation_x);
+
+        // incident + PEC image: Ez^2 ~ sin^2(ky * h), zeros every lambda / (2 sin(theta))
+        const double spacing = M_PI / ky / dx;
+
+        double minimum_1 = find_extremum(intensity, mirror_y + spacing, 6, false);
+        double minimum_2 = find_extremum(intensity, mirror_y + 2.0 * spacing, 6, false);
+
+        check("lloyd's mirror first minimum height [cells]", minimum_1 - mirror_y, spacing, 1.0);
+        check("lloyd's mirror second minimum height [cells]", minimum_2 - mirror_y, 2.0 * spacing, 1.5);
+        check("lloyd's mirror fringe spacing [cells]", minimum_2 - minimum_1, spacing, 1.0);
+    }
+
+    // -------- Point source: energy leaves through the absorbing layer --------
+    {
+        const int Nt = 1200;
+        SceneResult result = run_scene(point_source, FDTDCPU::Vectorized, Nt, 1, true);
+
+        double peak_energy = *std::max_element(result.energy.begin(), result.energy.end());
+        double final_energy = result.energy.back();
+
+        check("point source residual energy [fraction]", final_energy / peak_energy, 0.0, 2e-2);
+    }
+
+    // -------- Bloch periodic plane wave: wavevector of the transmitted wave --------
+    {
+        const int Nt = 1500;
+        SceneResult result = run_scene(bloch_plane_wave, FDTDCPU::Vectorized, Nt, 1, false);
+
+        const int Nx = bloch_plane_wave.resolution.x;
+        const int Ny = bloch_plane_wave.resolution.y;
+
+        // phase advance per cell from sum E(r) * conj(E(r + d)), fields go as exp(i * (w * t - k.r))
+        auto phase_advance = [&](glm::ivec2 step) {
+            double re = 0.0, im = 0.0;
+            for (int j = 0; j < Ny - step.y; ++j)
+                for (int i = bloch_src_x + 40; i < bloch_src_x + 140; ++i) {
+                    size_t a = j * Nx + i;
+                    size_t b = (j + step.y) * Nx + i + step.x;
+                    re += (double)result.Ez[a] * result.Ez[b] + (double)result.Ez_imaginary[a] * result.Ez_imaginary[b];
+                    im += (double)result.Ez_imaginary[a] * result.Ez[b] - (double)result.Ez[a] * result.Ez_imaginary[b];
+                }
+            return std::atan2(im, re);
+        };
+
+        // Yee dispersion: (sin(w dt / 2) / (c dt))^2 = (sin(kx dx / 2) / dx)^2 + (sin(ky dx / 2) / dx)^2
+        const double omega = 2.0 * M_PI * frequency;
+        const double temporal = std::sin(omega * dt / 2.0) / (c0 * dt);
+        const double transverse = std::sin(bloch_ky * dx / 2.0) / dx;
+        const double predicted_kx = 2.0 / dx * std::asin(dx * std::sqrt(temporal * temporal - transverse * transverse));
+
+        check("bloch plane wave ky [rad/cell]", phase_advance(glm::ivec2(0, 1)), bloch_ky * dx, 1e-3);
+        // the absorbing layer reflects a few percent at oblique incidence, which biases kx slightly
+        check("bloch plane wave kx [rad/cell]", phase_advance(glm::ivec2(1, 0)), predicted_kx * dx, 1e-2);
+    }
+
+    // -------- Symmetry planes: reduced domains against the full domain --------
+    // the fourth order taps read through the mirror, so (2,4) has to match the full domain as closely as order 2
+    Scene halved_pair_x = antisymmetric_pair;
+    halved_pair_x.name = "antisymmetric pair, even x plane";
+    halved_pair_x.symmetry_x = FDTD::EvenSymmetry;
+
+    Scene halved_pair_y = antisymmetric_pair;
+    halved_pair_y.name = "antisymmetric pair, odd y plane";
+    halved_pair_y.symmetry_y = FDTD::OddSymmetry;
+
+    for (int spatial_order : { 2, 4 }) {
+        for (auto [full, reduced] : { std::make_pair(&even_symmetric_slit, &halved_slit), std::make_pair(&antisymmetric_pair, &quartered_pair),
+                                      std::make_pair(&antisymmetric_pair, &halved_pair_x), std::make_pair(&antisymmetric_pair, &halved_pair_y) }) {
+
+            // the single plane pairs only guard the fourth order taps, order 2 is covered by the quartered pair
+            if (spatial_order == 2 && (reduced == &halved_pair_x || reduced == &halved_pair_y))
+                continue;
+
+            Scene full_scene = *full;
+            Scene reduced_scene = *reduced;
+            full_scene.spatial_order = spatial_order;
+            reduced_scene.spatial_order = spatial_order;
+
+            const int Nt = equivalence_ticks;
+            SceneResult full_result = run_scene(full_scene, FDTDCPU::Vectorized, Nt, 1, false);
+
+            for (FDTDCPU::KernelVariant variant : spatial_order == 4 ? std::vector<FDTDCPU::KernelVariant>{ FDTDCPU::Reference, FDTDCPU::Vectorized } : equivalence_variants) {
+                SceneResult reduced_result = run_scene(reduced_scene, variant, Nt, 1, false);
+                check(reduced->name + (spatial_order == 4 ? " (2,4) " : " ") + variant_name(variant) + " vs full",
+                    relative_difference(full_result.Ez, reduced_result.Ez), 0.0, float_variant_tolerance);
+            }
+        }
+    }
+
+    // -------- Fourth order stencil --------
+    // the wide taps fall back next to the slit screen, the mirror and inside the absorbing layer
+    Scene double_slit_fourth_order = double_slit;
+    double_slit_fourth_order.name = "double slit (2,4)";
+    double_slit_fourth_order.spatial_order = 4;
+
+    Scene lloyds_mirror_fourth_order = lloyds_mirror;
+    lloyds_mirror_fourth_order.name = "lloyd's mirror (2,4)";
+    lloyds_mirror_fourth_order.spatial_order = 4;
+
+    Scene bloch_plane_wave_fourth_order = bloch_plane_wave;
+    bloch_plane_wave_fourth_order.name = "bloch plane wave (2,4)";
+    bloch_plane_wave_fourth_order.spatial_order = 4;
+
+    // -------- Standing waves: numerical dispersion of both stencils --------
+    // FDTD(2,4) at half the cells per wavelength disperses less than the Yee stencil, both at their default Courant factor
+    {
+        const int cells_per_wavelength = 20;
+
+        double predicted_second_order = 0, predicted_fourth_order = 0;
+        double error_second_order = measure_standing_wave_dispersion(2, cells_per_wavelength, predicted_second_order);
+        double error_fourth_order = measure_standing_wave_dispersion(4, cells_per_wavelength / 2, predicted_fourth_order);
+
+        check("standing wave (2,2) N phase velocity error", error_second_order, predicted_second_order, 1e-4);
+        check("standing wave (2,4) N/2 phase velocity error", error_fourth_order, predicted_fourth_order, 1e-4);
+        check("standing wave |(2,4) N/2 error| below |(2,2) N|", std::abs(error_fourth_order), 0.0, std::abs(error_second_order));
+    }
+
+    // -------- Tiled kernel: uneven tiles on more threads than tiles per row --------
+    Scene double_slit_uneven_tiles = double_slit;
+    double_slit_uneven_tiles.name = "double slit, 3 threads 37x11 tiles";
+    double_slit_uneven_tiles.tile_size = glm::ivec2(37, 11);
+    double_slit_uneven_tiles.thread_count = 3;
+
+    Scene bloch_plane_wave_uneven_tiles = bloch_plane_wave_fourth_order;
+    bloch_plane_wave_uneven_tiles.name = "bloch plane wave (2,4), 3 threads 37x11 tiles";
+    bloch_plane_wave_uneven_tiles.tile_size = glm::ivec2(37, 11);
+    bloch_plane_wave_uneven_tiles.thread_count = 3;
+
+    // -------- Optimized variants against the reference kernels --------
+    // the default tier keeps one scene per source type, stencil, boundary and tiling
+    std::vector<const Scene*> variant_scenes = { &point_source, &lloyds_mirror, &bloch_plane_wave_uneven_tiles };
+    if (slow_tier)
+        variant_scenes = { &double_slit, &lloyds_mirror, &point_source, &bloch_plane_wave,
+            &double_slit_fourth_order, &lloyds_mirror_fourth_order, &bloch_plane_wave_fourth_order,
+            &double_slit_uneven_tiles, &bloch_plane_wave_uneven_tiles };
+
+    for (const Scene* scene : variant_scenes) {
+
+        const int Nt = equivalence_ticks;
+        SceneResult reference = run_scene(*scene, FDTDCPU::Reference, Nt, 1, false);
+
+        for (FDTDCPU::KernelVariant variant : optimized_variants) {
+            SceneResult optimized = run_scene(*scene, variant, Nt, 1, false);
+            check(scene->name + " " + variant_name(variant) + " vs reference",
+                relative_difference(reference.Ez, optimized.Ez), 0.0, float_variant_tolerance);
+            if (!reference.Ez_imaginary.empty())
+                check(scene->name + " " + variant_name(variant) + " vs reference, im",
+                    relative_difference(reference.Ez_imaginary, optimized.Ez_imaginary), 0.0, float_variant_tolerance);
+        }
+    }
+
+    // -------- Near to far field: contour around an antisymmetric pair --------
+    // the transform reproduces Ez outside the contour, cancels it inside and the far field follows
+    // the array factor |sin(k d / 2 * sin(angle))| of two opposite phase sources d apart along y.
+    // the run is time gated, accumulation ends before reflections off the absorbing layer reach the
+    // probes, the transform leaves out anything coming from outside the contour
+    {
+        const int Nxy = 601;
+        const int center = Nxy / 2;
+        const int separation = 60;
+        const int warmup_ticks = 320;
+        const int accumulate_ticks = (int)std::lround(14 * period_ticks);
+
+        const glm::ivec2 contour_begin(center - 50, center - 50), contour_end(center + 50, center + 50);
+        std::vector<glm::ivec2> outside_probes = { glm::ivec2(60, -20), glm::ivec2(60, 30), glm::ivec2(20, 60), glm::ivec2(-20, -60) };
+        std::vector<glm::ivec2> inside_probes = { glm::ivec2(-10, -10), glm::ivec2(20, 10), glm::ivec2(-30, 35) };
+        for (glm::ivec2& probe : outside_probes) probe = probe + glm::ivec2(center);
+        for (glm::ivec2& probe : inside_probes) probe = probe + glm::ivec2(center);
+
+        FDTDCPU solver;
+        solver.initialzie_fields(
+            [&](glm::ivec3 id, FDTD::ElectroMagneticProperty& property) {
+                if (id.x == center && std::abs(id.y - center) == separation / 2) {
+                    property.voxel_type = FDTD::SourceSinosoidalSoft;
+                    property.source_frequency = frequency;
+                    property.source_amplitude = 1;
+                    property.source_phase = id.y < center ? 0.0f : (float)M_PI;
+                }
+            },
+            glm::ivec3(Nxy, Nxy, 1), glm::ivec2(30), glm::ivec2(30));
+
+        NearToFarField transform(solver, { (float)frequency });
+        transform.add_rectangle(contour_begin, contour_end);
+
+        std::vector<std::complex<double>> probe_dft(outside_probes.size() + inside_probes.size(), 0.0);
+
+        for (int n = 0; n < warmup_ticks + accumulate_ticks; ++n) {
+            solver.step();
+
+            if (n < warmup_ticks)
+                continue;
+
+            transform.observe(solver);
+
+            std::complex<double> kernel = std::polar(1.0, -2.0 * M_PI * frequency * solver.get_total_ticks_elapsed() * dt);
+            for (size_t i = 0; i < probe_dft.size(); ++i) {
+                glm::ivec2 probe = i < outside_probes.size() ? outside_probes[i] : inside_probes[i - outside_probes.size()];
+                probe_dft[i] += 2.0 * solver.get_electric_field(glm::ivec3(probe.x, probe.y, 0)) * kernel;
+            }
+        }
+
+        std::vector<glm::vec2> positions;
+        for (glm::ivec2 probe : outside_probes) positions.push_back(glm::vec2(probe.x * dx, probe.y * dx));
+        for (glm::ivec2 probe : inside_probes) positions.push_back(glm::vec2(probe.x * dx, probe.y * dx));
+
+        std::vector<std::complex<double>> transformed = transform.compute_electric_field(0, positions);
+
+        double peak = 0, outside_error = 0, inside_residual = 0;
+        for (size_t i = 0; i < probe_dft.size(); ++i) {
+            std::complex<double> direct = probe_dft[i] / (double)transform.get_observed_tick_count();
+            if (i < outside_probes.size()) {
+                peak = std::max(peak, std::abs(direct));
+                outside_error = std::max(outside_error, std::abs(transformed[i] - direct));
+            }
+            else {
+                inside_residual = std::max(inside_residual, std::abs(transformed[i]));
+            }
+        }
+
+        check("near to far field outside contour vs probes", outside_error / peak, 0.0, 3e-2);
+        check("near to far field inside contour residual", inside_residual / peak, 0.0, 3e-2);
+
+        const int angle_count = 360;
+        std::vector<float> angles;
+        for (int i = 0; i < angle_count; ++i)
+            angles.push_back(2.0f * (float)M_PI * i / angle_count);
+
+        glm::vec2 origin(center * dx, center * dx);
+        std::vector<std::complex<double>> pattern = transform.compute_far_field_pattern(0, angles, origin);
+
+        double pattern_peak = 0, array_factor_peak = 0;
+        std::vector<double> array_factor(angle_count);
+        for (int i = 0; i < angle_count; ++i) {
+            array_factor[i] = std::abs(std::sin(M_PI / lambda * separation * dx * std::sin(angles[i])));
+            array_factor_peak = std::max(array_factor_peak, array_factor[i]);
+            pattern_peak = std::max(pattern_peak, std::abs(pattern[i]));
+        }
+
+        double pattern_error = 0;
+        for (int i = 0; i < angle_count; ++i)
+            pattern_error = std::max(pattern_error, std::abs(std::abs(pattern[i]) / pattern_peak - array_factor[i] / array_factor_peak));
+
+        check("near to far field pattern vs array factor", pattern_error, 0.0, 5e-2);
+    }
+
+    // -------- Autotuner: the stored winner is loaded back by a new solver --------
+    {
+        const std::string profile_path = "validation_autotune_profile.txt";
+        std::remove(profile_path.c_str());
+
+        auto initialize = [&](FDTDCPU& solver) {
+            solver.initialzie_fields(point_source.initialization, point_source.resolution, glm::ivec2(point_source.pml), glm::ivec2(point_source.pml));
+        };
+
+        FDTDCPU tuned;
+        tuned.autotune_profile_path = profile_path;
+        tuned.autotune_if_missing = true;
+        initialize(tuned);
+
+        FDTDCPU loaded;
+        loaded.kernel_variant = FDTDCPU::Reference;
+        loaded.autotune_profile_path = profile_path;
+        initialize(loaded);
+
+        bool same_configuration = loaded.kernel_variant == tuned.kernel_variant &&
+            loaded.tile_size == tuned.tile_size && loaded.thread_count == tuned.thread_count;
+
+        check("autotune profile round trip [mismatches]", same_configuration ? 0.0 : 1.0, 0.0, 0.0);
+        check("autotune leaves the solver at tick 0", tuned.get_total_ticks_elapsed(), 0.0, 0.0);
+
+        // a hand edited entry that does not parse counts as missing instead of throwing
+        {
+            std::ofstream profile(profile_path, std::ios::trunc);
+            profile << FDTDAutotuner::get_cpu_model() << " | " << FDTDAutotuner::get_grid_class(tuned) << " | 1 | 0 | sixteen | 1 | 1e9\n";
+        }
+        FDTDAutotuner::Configuration malformed;
+        bool malformed_loaded = FDTDAutotuner::load_profile(profile_path, FDTDAutotuner::get_cpu_model(), FDTDAutotuner::get_grid_class(tuned), malformed);
+        check("autotune malformed profile entry [loaded]", malformed_loaded ? 1.0 : 0.0, 0.0, 0.0);
+
+        std::remove(profile_path.c_str());
+    }
+
+    // -------- Warm start: patched properties match a cold start of the patched scene --------
+    {
+        const int Nt = slow_tier ? 150 : 100;
+
+        auto initialize = [&](FDTDCPU& solver, const Scene& scene, int spatial_order) {
+            solver.spatial_order = spatial_order;
+            solver.initialzie_fields(scene.initialization, scene.resolution, glm::ivec2(scene.pml), glm::ivec2(scene.pml));
+        };
+
+        std::vector<std::pair<const Scene*, const Scene*>> transitions = {
+            { &double_slit, &wide_double_slit },
+            { &double_slit, &hard_source_double_slit },
+        };
+        if (slow_tier)
+            transitions.push_back({ &wide_double_slit, &double_slit });
+
+        // the fourth order stencil also rebuilds the masks around the patched cells
+        for (int spatial_order : slow_tier ? std::vector<int>{ 2, 4 } : std::vector<int>{ 4 }) {
+            for (auto [previous, next] : transitions) {
+
+                std::vector<FDTD::PropertyPatch> patches = FDTD::compute_property_patches(previous->initialization, next->initialization, next->resolution);
+
+                FDTDCPU patched;
+                initialize(patched, *previous, spatial_order);
+                patched.patch_properties(patches);
+                patched.iterate_time(Nt);
+
+                FDTDCPU cold;
+                initialize(cold, *next, spatial_order);
+                cold.iterate_time(Nt);
+
+                check(previous->name + " -> " + next->name + ", order " + std::to_string(spatial_order) + " patched vs cold",
+                    relative_difference(cold.electric_field, patched.electric_field), 0.0, 0.0);
+            }
+        }
+
+        // opening the slits mid run keeps every field, so the patched solver continues exactly like the wide scene loaded with the same fields
+        FDTDCPU patched;
+        initialize(patched, double_slit, 2);
+        patched.iterate_time(Nt);
+
+        const std::string state_path = "validation_field_state.bin";
+        patched.get_field_state().save(state_path);
+
+        FDTDCPU loaded;
+        initialize(loaded, wide_double_slit, 2);
+        loaded.load_field_state(FieldState::load(state_path));
+        std::remove(state_path.c_str());
+
+        patched.patch_properties(FDTD::compute_property_patches(double_slit.initialization, wide_double_slit.initialization, double_slit.resolution));
+        patched.iterate_time(Nt);
+        loaded.iterate_time(Nt);
+
+        check("field state saved mid run vs patched in place", relative_difference(patched.electric_field, loaded.electric_field), 0.0, 0.0);
+        check("field state restores the tick", loaded.get_total_ticks_elapsed(), 2.0 * Nt, 0.0);
+    }
+
+    // -------- Warm start: a one cell wider slit settles from the narrow slit's steady state --------
+    if (slow_tier) {
+        const int observation_x = slit_screen_x + 1 + 80;
+        const int max_ticks = 3000;
+
+        SceneResult cold = run_scene_until_steady(wide_double_slit, FDTDCPU::Vectorized, max_ticks, period_ticks, observation_x);
+        SceneResult warm = run_scene_until_steady(wide_double_slit, FDTDCPU::Vectorized, max_ticks, period_ticks, observation_x, &settled_double_slit);
+
+        std::vector<double> cold_intensity = column(cold.Ez2_mean, wide_double_slit.resolution, observation_x);
+        std::vector<double> warm_intensity = column(warm.Ez2_mean, wide_double_slit.resolution, observation_x);
+
+        double max_difference = 0.0, peak = 0.0;
+        for (int j = wide_double_slit.pml; j < wide_double_slit.resolution.y - wide_double_slit.pml; ++j) {
+            max_difference = std::max(max_difference, std::abs(warm_intensity[j] - cold_intensity[j]));
+            peak = std::max(peak, cold_intensity[j]);
+        }
+
+        // the monitor still needs a few settled windows, only the transient of the opened cells is left to decay
+        check("warm start ticks to steady state [fraction of cold]", (double)warm.ticks_to_steady / cold.ticks_to_steady, 0.0, 0.8);
+        check("warm start intensity vs cold start", max_difference / peak, 0.0, 2e-2);
+    }
+
+    // -------- Ensemble: members against separate runs --------
+    {
+        const int Nt = slow_tier ? 150 : 100;
+
+        // one geometry, every member drives the slits at its own frequency, amplitude and phase
+        auto make_members = [&](int member_count) {
+            std::vector<std::function<void(glm::ivec3, FDTD::ElectroMagneticProperty&)>> members;
+            for (int m = 0; m < member_count; ++m)
+                members.push_back([&, m](glm::ivec3 id, FDTD::ElectroMagneticProperty& property) {
+                    double_slit.initialization(id, property);
+                    if (property.voxel_type == FDTD::SourceSinosoidalSoft) {
+                        property.source_frequency = frequency * (0.8 + 0.05 * m);
+                        property.source_amplitude = 1.0f + 0.25f * m;
+                        property.source_phase = 0.3f * m;
+                    }
+                });
+            return members;
+        };
+
+        auto run_separately = [&](const std::vector<std::function<void(glm::ivec3, FDTD::ElectroMagneticProperty&)>>& members, FDTDCPU::KernelVariant variant, int spatial_order) {
+            std::vector<std::vector<float>> fields;
+            for (auto& member : members) {
+                FDTDCPU solver;
+                solver.kernel_variant = variant;
+                solver.spatial_order = spatial_order;
+                solver.initialzie_fields(member, double_slit.resolution, glm::ivec2(double_slit.pml), glm::ivec2(double_slit.pml));
+                solver.iterate_time(Nt);
+                fields.push_back(solver.get_unfolded_electric_field());
+            }
+            return fields;
+        };
+
+        struct EnsembleCase { int member_count; int spatial_order; std::vector<FDTDCPU::KernelVariant> variants; };
+        std::vector<EnsembleCase> cases = {
+            { 3, 2, { FDTDCPU::Tiled } },
+            { 3, 4, { FDTDCPU::Vectorized } },
+        };
+        if (slow_tier)
+            cases = {
+                { 8, 2, { FDTDCPU::Vectorized, FDTDCPU::Tiled } },
+                { 3, 4, { FDTDCPU::Reference, FDTDCPU::Vectorized } },
+            };
+
+        for (const EnsembleCase& ensemble_case : cases) {
+
+            auto members = make_members(ensemble_case.member_count);
+            std::vector<std::vector<float>> separate = run_separately(members, slow_tier ? FDTDCPU::Reference : FDTDCPU::Vectorized, ensemble_case.spatial_order);
+
+            for (FDTDCPU::KernelVariant variant : ensemble_case.variants) {
+
+                FDTDCPU ensemble;
+                ensemble.kernel_variant = variant;
+                ensemble.spatial_order = ensemble_case.spatial_order;
+                ensemble.initialzie_fields(members, double_slit.resolution, glm::ivec2(double_slit.pml), glm::ivec2(double_slit.pml));
+                ensemble.iterate_time(Nt);
+
+                double worst = 0.0;
+                for (int m = 0; m < ensemble_case.member_count; ++m)
+                    worst = std::max(worst, relative_difference(separate[m], ensemble.get_unfolded_electric_field(m)));
+
+                check("ensemble of " + std::to_string(ensemble_case.member_count) + ", order " + std::to_string(ensemble_case.spatial_order) +
+                    " " + variant_name(variant) + " vs separate runs", worst, 0.0, float_variant_tolerance);
+            }
+        }
+
+        // throughput of 8 members in lockstep against 8 separate runs of the vectorized kernel
+        if (slow_tier) {
+            auto members = make_members(8);
+
+            auto separate_begin = std::chrono::steady_clock::now();
+            run_separately(members, FDTDCPU::Vectorized, 2);
+            double separate_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - separate_begin).count();
+
+            auto ensemble_begin = std::chrono::steady_clock::now();
+            FDTDCPU ensemble;
+            ensemble.initialzie_fields(members, double_slit.resolution, glm::ivec2(double_slit.pml), glm::ivec2(double_slit.pml));
+            ensemble.iterate_time(Nt);
+            double ensemble_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - ensemble_begin).count();
+
+            printf("[INFO] %-48s %.3f s separately, %.3f s as an ensemble, %.2fx\n",
+                "ensemble of 8 vectorized", separate_seconds, ensemble_seconds, separate_seconds / ensemble_seconds);
+
+            // the lanes of a cell are one simd vector, the ensemble has to beat the separate runs even when
+            // the compiler vectorizes the single lane rows and the members no longer fit in cache
+            check("ensemble of 8 time [fraction of separate runs]", ensemble_seconds / separate_seconds, 0.0, 0.9);
+        }
+    }
+
+    // -------- Ensemble: warm start with per member patches --------
+    {
+        const int Nt = slow_tier ? 150 : 100;
+        const int member_count = 3;
+
+        // every member settles with its own soft sources, then the slits widen and turn into hard sources of its own amplitude
+        using Lambda = std::function<void(glm::ivec3, FDTD::ElectroMagneticProperty&)>;
+        std::vector<Lambda> previous_members, next_members;
+        for (int m = 0; m < member_count; ++m) {
+            previous_members.push_back([&, m](glm::ivec3 id, FDTD::ElectroMagneticProperty& property) {
+                double_slit.initialization(id, property);
+                if (property.voxel_type == FDTD::SourceSinosoidalSoft)
+                    property.source_frequency = frequency * (0.8 + 0.1 * m);
+            });
+            next_members.push_back([&, m](glm::ivec3 id, FDTD::ElectroMagneticProperty& property) {
+                wide_double_slit.initialization(id, property);
+                if (property.voxel_type == FDTD::SourceSinosoidalSoft) {
+                    property.voxel_type = FDTD::SourceSinosoidal;
+                    property.source_frequency = frequency * (0.8 + 0.1 * m);
+                    property.source_amplitude = 0.5f + 0.25f * m;
+                }
+            });
+        }
+
+        std::vector<std::vector<FDTD::PropertyPatch>> member_patches;
+        for (int m = 0; m < member_count; ++m)
+            member_patches.push_back(FDTD::compute_property_patches(previous_members[m], next_members[m], double_slit.resolution));
+
+        // the ensemble starts from member 0's state in every member, as a warm start from a saved state does
+        FDTDCPU settled;
+        settled.initialzie_fields(previous_members[0], double_slit.resolution, glm::ivec2(double_slit.pml), glm::ivec2(double_slit.pml));
+        settled.iterate_time(Nt);
+        FieldState state = settled.get_field_state();
+
+        for (int spatial_order : slow_tier ? std::vector<int>{ 2, 4 } : std::vector<int>{ 4 }) {
+
+            FDTDCPU ensemble;
+            ensemble.spatial_order = spatial_order;
+            ensemble.initialzie_fields(previous_members, double_slit.resolution, glm::ivec2(double_slit.pml), glm::ivec2(double_slit.pml));
+            ensemble.load_field_state(state);
+            ensemble.patch_properties(member_patches);
+            ensemble.iterate_time(Nt);
+
+            double worst = 0.0;
+            for (int m = 0; m < member_count; ++m) {
+                FDTDCPU separate;
+                separate.spatial_order = spatial_order;
+                separate.initialzie_fields(previous_members[m], double_slit.resolution, glm::ivec2(double_slit.pml), glm::ivec2(double_slit.pml));
+                separate.load_field_state(state);
+                separate.patch_properties(member_patches[m]);
+                separate.iterate_time(Nt);
+
+                worst = std::max(worst, relative_difference(separate.get_unfolded_electric_field(), ensemble.get_unfolded_electric_field(m)));
+            }
+
+            check("ensemble warm start of " + std::to_string(member_count) + ", order " + std::to_string(spatial_order) + " vs separate runs",
+                worst, 0.0, float_variant_tolerance);
+        }
+    }
+
+    // -------- Probes: recorded signals against direct samples --------
+    {
+        const int Nt = 300;
+        const int ring_ticks = 16;
+        const Scene& scene = quartered_pair;
+
+        FDTDCPU solver;
+        solver.symmetry_x = scene.symmetry_x;
+        solver.symmetry_y = scene.symmetry_y;
+        solver.initialzie_fields(scene.initialization, scene.resolution, glm::ivec2(scene.pml), glm::ivec2(scene.pml));
+
+        auto sample = [&](FDTDCPU::FieldComponent component, glm::ivec2 cell) {
+            glm::ivec3 id(cell.x, cell.y, 0);
+            switch (component) {
+            case FDTDCPU::ElectricZ:    return solver.get_electric_field(id);
+            case FDTDCPU::MagneticX:    return solver.get_magnetic_field_x(id);
+            case FDTDCPU::MagneticY:    return solver.get_magnetic_field_y(id);
+            }
+            return 0.0f;
+        };
+
+        // bilinear over the nodes of the component, Hx nodes are half a cell up and Hy nodes half a cell right
+        auto interpolate = [&](FDTDCPU::FieldComponent component, glm::vec2 position) {
+            float node_x = position.x - (component == FDTDCPU::MagneticY ? 0.5f : 0.0f);
+            float node_y = position.y - (component == FDTDCPU::MagneticX ? 0.5f : 0.0f);
+            int x = (int)std::floor(node_x), y = (int)std::floor(node_y);
+            float fx = node_x - x, fy = node_y - y;
+            float value = 0;
+            for (int dy = 0; dy < 2; ++dy)
+                for (int dx = 0; dx < 2; ++dx) {
+                    float weight = (dx == 1 ? fx : 1.0f - fx) * (dy == 1 ? fy : 1.0f - fy);
+                    if (weight != 0)
+                        value += weight * sample(component, glm::ivec2(x + dx, y + dy));
+                }
+            return value;
+        };
+
+        // probes straddle both symmetry planes of the quartered pair, so mirrored cells are read as well
+        struct PointProbe { FDTDCPU::FieldComponent component; glm::vec2 position; bool interpolated; };
+        std::vector<PointProbe> points;
+        points.push_back({ FDTDCPU::ElectricZ, glm::vec2(100, 70), false });
+        points.push_back({ FDTDCPU::ElectricZ, glm::vec2(60.25f, 150.5f), true });
+        points.push_back({ FDTDCPU::MagneticY, glm::vec2(99.5f, 99.75f), true });
+        for (int i = 0; i < 41; ++i)
+            points.push_back({ FDTDCPU::MagneticX, glm::vec2(80 + i, 100.5f - 0.4f * i), true });
+        for (int y = 95; y <= 105; ++y)
+            for (int x = 95; x <= 105; ++x)
+                points.push_back({ FDTDCPU::ElectricZ, glm::vec2(x, y), false });
+
+        std::vector<std::unique_ptr<ProbeRecorder>> recorders;
+        recorders.push_back(std::make_unique<ProbeRecorder>(solver, "validation_probes.gzpr", ProbeRecorder::Binary, ring_ticks));
+        recorders.push_back(std::make_unique<ProbeRecorder>(solver, "validation_probes.csv", ProbeRecorder::CSV, ring_ticks));
+
+        for (auto& recorder : recorders) {
+            recorder->add_point(glm::ivec2(100, 70), FDTDCPU::ElectricZ);
+            recorder->add_point(glm::vec2(60.25f, 150.5f), FDTDCPU::ElectricZ);
+            recorder->add_point(glm::vec2(99.5f, 99.75f), FDTDCPU::MagneticY);
+            recorder->add_line(glm::vec2(80, 100.5f), glm::vec2(120, 84.5f), 41, FDTDCPU::MagneticX);
+            recorder->add_box(glm::ivec2(95, 95), glm::ivec2(105, 105), FDTDCPU::ElectricZ);
+        }
+
+        std::vector<float> expected;
+        for (int n = 0; n < Nt; ++n) {
+            solver.step();
+            for (auto& recorder : recorders)
+                recorder->observe();
+            for (const PointProbe& point : points)
+                expected.push_back(point.interpolated ?
+                    interpolate(point.component, point.position) :
+                    sample(point.component, glm::ivec2((int)point.position.x, (int)point.position.y)));
+        }
+
+        // the binary file is complete after flush(), the csv one after close()
+        recorders[0]->flush();
+        ProbeSeries series = ProbeSeries::load("validation_probes.gzpr");
+        recorders.clear();
+
+        std::vector<float> csv_samples;
+        int csv_rows = 0;
+        FILE* csv = fopen("validation_probes.csv", "r");
+        if (csv != nullptr) {
+            std::vector<char> line(1 << 16);
+            fgets(line.data(), (int)line.size(), csv);
+            while (fgets(line.data(), (int)line.size(), csv) != nullptr) {
+                char* cursor = std::strchr(line.data(), ',');
+                while (cursor != nullptr) {
+                    csv_samples.push_back(std::strtof(cursor + 1, &cursor));
+                    cursor = std::strchr(cursor, ',');
+                }
+                csv_rows++;
+            }
+            fclose(csv);
+        }
+
+        double peak = 0.0, binary_error = 0.0, csv_error = 0.0;
+        for (float value : expected)
+            peak = std::max(peak, (double)std::abs(value));
+        for (size_t i = 0; i < expected.size(); ++i) {
+            binary_error = std::max(binary_error, i < series.samples.size() ? (double)std::abs(series.samples[i] - expected[i]) : peak);
+            csv_error = std::max(csv_error, i < csv_samples.size() ? (double)std::abs(csv_samples[i] - expected[i]) : peak);
+        }
+
+        bool ticks_in_order = series.get_row_count() == Nt;
+        for (int n = 0; n < series.get_row_count() && ticks_in_order; ++n)
+            ticks_in_order = series.ticks[n] == n + 1;
+
+        check("probes binary rows [ticks]", series.get_row_count(), Nt, 0.0);
+        check("probes binary channels", (double)series.channels.size(), (double)points.size(), 0.0);
+        check("probes binary ticks out of order", ticks_in_order ? 0.0 : 1.0, 0.0, 0.0);
+        check("probes binary vs direct samples", binary_error / peak, 0.0, 0.0);
+        check("probes csv rows [ticks]", csv_rows, Nt, 0.0);
+        check("probes csv vs direct samples", csv_error / peak, 0.0, 0.0);
+
+        // cost of 4096 channels against the step they watch
+        if (slow_tier) {
+            FDTDCPU timed;
+            timed.initialzie_fields(double_slit.initialization, double_slit.resolution, glm::ivec2(double_slit.pml), glm::ivec2(double_slit.pml));
+            ProbeRecorder recorder(timed, "validation_probes_timed.gzpr");
+            recorder.add_box(glm::ivec2(200, 128), glm::ivec2(263, 191), FDTDCPU::ElectricZ);
+
+            double step_seconds = 0.0, observe_seconds = 0.0;
+            for (int n = 0; n < Nt; ++n) {
+                auto step_begin = std::chrono::steady_clock::now();
+                timed.step();
+                auto observe_begin = std::chrono::steady_clock::now();
+                recorder.observe();
+                auto observe_end = std::chrono::steady_clock::now();
+                step_seconds += std::chrono::duration<double>(observe_begin - step_begin).count();
+                observe_seconds += std::chrono::duration<double>(observe_end - observe_begin).count();
+            }
+            recorder.close();
+
+            printf("[INFO] %-48s %.3f ms per step, %.4f ms per observe, %.2f%% of a step, %d ticks waited\n",
+                "probes, 4096 channels", 1e3 * step_seconds / Nt, 1e3 * observe_seconds / Nt, 100.0 * observe_seconds / step_seconds, recorder.get_waited_tick_count());
+        }
+    }
+
+    // -------- Field series: decoded frames against the written ones --------
+    // a blob moves across a fixed noisy background, frames are cropped and decimated, the last chunk is partial and frames are read back to front across chunks
+    {
+        const glm::ivec3 grid(97, 61, 1);
+        const int frame_count = 21;
+
+        auto field = [&](int frame, glm::ivec3 id) {
+            uint32_t hash = ((uint32_t)id.x * 73856093u ^ (uint32_t)id.y * 19349663u) * 2654435761u;
+            double background = 0.3 * ((hash >> 8) / 16777216.0 - 0.5);
+            double blob = std::exp(-(std::pow(id.x - 10.0 - 3.0 * frame, 2) + std::pow(id.y - 30.0, 2)) / 20.0);
+            return (float)(background + blob * std::cos(0.7 * frame));
+        };
+
+        auto write_series = [&](const std::string& path, float value_scale, int frames_per_chunk) {
+            FieldSeriesWriter::Description description;
+            description.grid_resolution = grid;
+            description.crop_begin = glm::ivec3(5, 3, 0);
+            description.crop_size = glm::ivec3(80, 50, 0);
+            description.decimation = glm::ivec3(2, 1, 1);
+            description.frames_per_chunk = frames_per_chunk;
+            description.value_scale = value_scale;
+
+            FieldSeriesWriter writer(path, description);
+            std::vector<float> grid_data((size_t)grid.x * grid.y);
+            for (int frame = 0; frame < frame_count; ++frame) {
+                for (int y = 0; y < grid.y; ++y)
+                    for (int x = 0; x < grid.x; ++x)
+                        grid_data[(size_t)y * grid.x + x] = field(frame, glm::ivec3(x, y, 0));
+                writer.append_frame(grid_data.data());
+            }
+            writer.close();
+        };
+
+        auto file_size = [](const std::string& path) {
+            FILE* file = fopen(path.c_str(), "rb");
+            fseek(file, 0, SEEK_END);
+            long size = ftell(file);
+            fclose(file);
+            return size;
+        };
+
+        const int quantization_max = (1 << (12 - 1)) - 1;
+        const int frames_per_chunk = 8;
+
+        for (float value_scale : { 0.0f, 2.0f }) {
+            std::string label = value_scale > 0 ? "field series, shared scale" : "field series, chunk scale";
+            write_series("validation_series.gzfs", value_scale, frames_per_chunk);
+
+            FieldSeriesReader reader("validation_series.gzfs");
+            check(label + " frames", reader.get_frame_count(), frame_count, 0);
+            check(label + " frame width", reader.get_frame_resolution().x, 40, 0);
+
+            // error in units of half a quantization step of the frame's chunk
+            double worst_error = 0;
+            for (int frame = frame_count - 1; frame >= 0; --frame) {
+                int chunk_begin = frame / frames_per_chunk * frames_per_chunk;
+                int chunk_end = std::min(chunk_begin + frames_per_chunk, frame_count);
+
+                double scale = value_scale;
+                if (scale <= 0)
+                    for (int chunk_frame = chunk_begin; chunk_frame < chunk_end; ++chunk_frame)
+                        for (int y = 0; y < 50; ++y)
+                            for (int x = 0; x < 40; ++x)
+                                scale = std::max(scale, (double)std::abs(field(chunk_frame, glm::ivec3(5 + 2 * x, 3 + y, 0))));
+                double half_step = 0.5 * scale / quantization_max;
+
+                std::vector<float> decoded = reader.read_frame(frame);
+                for (int y = 0; y < 50; ++y)
+                    for (int x = 0; x < 40; ++x)
+                        worst_error = std::max(worst_error, std::abs(decoded[(size_t)y * 40 + x] - field(frame, glm::ivec3(5 + 2 * x, 3 + y, 0))) / half_step);
+            }
+            check(label + " error [half steps]", worst_error, 0.0, 1.001);
+        }
+
+        // a double slit series against the PNG frames it replaces, both with 8 bits
+        FDTDCPU solver;
+        solver.initialzie_fields(double_slit.initialization, double_slit.resolution, glm::ivec2(double_slit.pml), glm::ivec2(double_slit.pml));
+
+        const glm::ivec3 slit_grid = double_slit.resolution;
+        const size_t slit_cell_count = (size_t)slit_grid.x * slit_grid.y;
+        std::vector<float> slit_frames;
+        for (int n = 1; n <= 300; ++n) {
+            solver.step();
+            if (n % 10 == 0)
+                slit_frames.insert(slit_frames.end(), solver.electric_field.begin(), solver.electric_field.end());
+        }
+
+        float slit_scale = 0;
+        for (float value : slit_frames)
+            slit_scale = std::max(slit_scale, std::abs(value));
+
+        FieldSeriesWriter::Description slit_description;
+        slit_description.grid_resolution = slit_grid;
+        slit_description.value_scale = slit_scale;
+        slit_description.quantization_bits = 8;
+
+        FieldSeriesWriter slit_writer("validation_series.gzfs", slit_description);
+        long png_size = 0;
+        std::vector<unsigned char> pixels(slit_cell_count);
+        for (size_t frame = 0; frame < slit_frames.size() / slit_cell_count; ++frame) {
+            const float* frame_data = slit_frames.data() + frame * slit_cell_count;
+            slit_writer.append_frame(frame_data);
+
+            for (size_t i = 0; i < slit_cell_count; ++i)
+                pixels[i] = (unsigned char)std::lround(127.5 + 127.5 * frame_data[i] / slit_scale);
+
+            int size = 0;
+            unsigned char* png = stbi_write_png_to_mem(pixels.data(), slit_grid.x, slit_grid.x, slit_grid.y, 1, &size);
+            png_size += size;
+            STBIW_FREE(png);
+        }
+        slit_writer.close();
+
+        check("field series / 8 bit PNG size, double slit", (double)file_size("validation_series.gzfs") / png_size, 0.0, 1.0);
+    }
+
+    // -------- Graded mesh: uniform spacing given as a graded mesh is the uniform mesh --------
+    for (const Scene* scene : { &double_slit, &double_slit_fourth_order }) {
+
+        Scene uniform_graded = *scene;
+        uniform_graded.name = scene->name + ", uniform graded mesh";
+        uniform_graded.graded_spacing_x.assign(scene->resolution.x, (float)dx);
+        uniform_graded.graded_spacing_y.assign(scene->resolution.y, (float)dx);
+
+        const int Nt = equivalence_ticks;
+        for (FDTDCPU::KernelVariant variant : equivalence_variants) {
+            SceneResult uniform = run_scene(*scene, variant, Nt, 1, false);
+            SceneResult graded = run_scene(uniform_graded, variant, Nt, 1, false);
+            check(uniform_graded.name + " " + variant_name(variant) + " vs uniform",
+                relative_difference(uniform.Ez, graded.Ez), 0.0, 0.0);
+        }
+    }
+
+    // -------- Graded mesh: symmetry plane and fourth order stencil on a graded y axis --------
+    {
+        // fine rows over the slits, 0.1 cells wider per row beyond them up to 2 cells, mirrored about the middle row
+        std::vector<float> upper_spacing_y;
+        for (int j = 0; j < even_symmetric_slit.resolution.y / 2; ++j)
+            upper_spacing_y.push_back((float)(dx * std::min(2.0, 1.0 + 0.1 * std::max(0, j - 40))));
+
+        Scene graded_slit = even_symmetric_slit;
+        graded_slit.name = "double slit, graded y";
+        graded_slit.graded_spacing_y.assign(upper_spacing_y.rbegin(), upper_spacing_y.rend());
+        graded_slit.graded_spacing_y.insert(graded_slit.graded_spacing_y.end(), upper_spacing_y.begin(), upper_spacing_y.end());
+        graded_slit.graded_spacing_y.push_back(upper_spacing_y.back());
+
+        Scene halved_graded_slit = graded_slit;
+        halved_graded_slit.name = "double slit, graded y, even y plane";
+        halved_graded_slit.symmetry_y = FDTD::EvenSymmetry;
+
+        Scene graded_slit_fourth_order = graded_slit;
+        graded_slit_fourth_order.name = "double slit, graded y (2,4)";
+        graded_slit_fourth_order.spatial_order = 4;
+
+        const int Nt = equivalence_ticks;
+        SceneResult full_result = run_scene(graded_slit, FDTDCPU::Vectorized, Nt, 1, false);
+
+        for (FDTDCPU::KernelVariant variant : equivalence_variants) {
+            SceneResult halved_result = run_scene(halved_graded_slit, variant, Nt, 1, false);
+            check(halved_graded_slit.name + " " + variant_name(variant) + " vs full",
+                relative_difference(full_result.Ez, halved_result.Ez), 0.0, float_variant_tolerance);
+        }
+
+        Scene halved_graded_slit_fourth_order = halved_graded_slit;
+        halved_graded_slit_fourth_order.name = "double slit, graded y, even y plane (2,4)";
+        halved_graded_slit_fourth_order.spatial_order = 4;
+
+        SceneResult full_fourth_order_result = run_scene(graded_slit_fourth_order, FDTDCPU::Vectorized, Nt, 1, false);
+        SceneResult halved_fourth_order_result = run_scene(halved_graded_slit_fourth_order, FDTDCPU::Vectorized, Nt, 1, false);
+        check(halved_graded_slit_fourth_order.name + " vectorized vs full",
+            relative_difference(full_fourth_order_result.Ez, halved_fourth_order_result.Ez), 0.0, float_variant_tolerance);
+
+        if (slow_tier) {
+            SceneResult reference = run_scene(graded_slit_fourth_order, FDTDCPU::Reference, Nt, 1, false);
+            for (FDTDCPU::KernelVariant variant : optimized_variants) {
+                SceneResult optimized = run_scene(graded_slit_fourth_order, variant, Nt, 1, false);
+                check(graded_slit_fourth_order.name + " " + variant_name(variant) + " vs reference",
+                    relative_difference(reference.Ez, optimized.Ez), 0.0, float_variant_tolerance);
+            }
+        }
+    }
+
+    // -------- Graded mesh: double slit coarsened to a tenth of a wavelength away from the screen --------
+    // the screen and the observation column stay on fine cells, the fringes along y follow the uniform mesh
+    if (slow_tier) {
+        const int observation_x = slit_screen_x + 1 + 80;
+
+        Scene graded_slit = double_slit;
+        graded_slit.name = "double slit, graded x";
+        graded_slit.graded_spacing_x = FDTD::compute_graded_spacing((float)(double_slit.resolution.x * dx), (float)dx, (float)(2 * dx), {
+            glm::vec2((slit_screen_x - 10) * dx, (slit_screen_x + 12) * dx),
+            glm::vec2((observation_x - 5) * dx, (observation_x + 5) * dx),
+        });
+        graded_slit.resolution.x = (int)graded_slit.graded_spacing_x.size();
+
+        // columns of the uniform scene moved to the nearest graded node
+        std::vector<float> position_x = FDTD::compute_node_positions(graded_slit.graded_spacing_x);
+        auto nearest_node = [&](int x) {
+            auto distance = [&](float position) { return std::abs(position - x * dx); };
+            return (int)(std::min_element(position_x.begin(), position_x.end(), [&](float a, float b) { return distance(a) < distance(b); }) - position_x.begin());
+        };
+        const int graded_source_x = nearest_node(slit_screen_x - 40);
+        const int graded_screen_x = nearest_node(slit_screen_x);
+        const int graded_observation_x = nearest_node(observation_x);
+
+        graded_slit.initialization = [&](glm::ivec3 id, FDTD::ElectroMagneticProperty& property) {
+            int center_y = graded_slit.resolution.y / 2;
+            if (id.x == graded_source_x) {
+                property.voxel_type = FDTD::SourceSinosoidalSoft;
+                property.source_frequency = frequency;
+                property.source_amplitude = 1;
+            }
+            bool slit1 = std::abs(id.y - (center_y - slit_sep / 2)) <= slit_half_width;
+            bool slit2 = std::abs(id.y - (center_y + slit_sep / 2)) <= slit_half_width;
+            if ((id.x == graded_screen_x || id.x == graded_screen_x + 1) && !(slit1 || slit2))
+                property.voxel_type = FDTD::PEC;
+        };
+
+        Scene uniform_slit = double_slit;
+        uniform_slit.name = "double slit, uniform x";
+
+        const int max_ticks = 3000;
+        SceneResult uniform = run_scene_until_steady(uniform_slit, FDTDCPU::Vectorized, max_ticks, period_ticks, observation_x);
+        SceneResult graded = run_scene_until_steady(graded_slit, FDTDCPU::Vectorized, max_ticks, period_ticks, graded_observation_x);
+
+        std::vector<double> uniform_intensity = column(uniform.Ez2_mean, uniform_slit.resolution, observation_x);
+        std::vector<double> graded_intensity = column(graded.Ez2_mean, graded_slit.resolution, graded_observation_x);
+
+        // point slits put order m at sin(theta) = m * lambda / separation
+        const double L = observation_x - (slit_screen_x + 1);
+        const double center_y = double_slit.resolution.y / 2;
+
+        struct Fringe { const char* name; double order; bool maximum; };
+        for (Fringe fringe : { Fringe{ "central maximum", 0.0, true }, Fringe{ "first order maximum +1", 1.0, true },
+            Fringe{ "first order maximum -1", -1.0, true }, Fringe{ "first minimum", 0.5, false }, Fringe{ "second minimum", 1.5, false } }) {
+
+            double guess = center_y + L * std::tan(std::asin(fringe.order * lambda_cells / slit_sep));
+            double uniform_y = find_extremum(uniform_intensity, guess, 8, fringe.maximum);
+            double graded_y = find_extremum(graded_intensity, uniform_y, 4, fringe.maximum);
+            check(std::string("graded double slit ") + fringe.name + " [cells]", graded_y, uniform_y, 1.0);
+        }
+
+        printf("[INFO] %-48s %d of %d columns\n", "double slit, graded x", graded_slit.resolution.x, uniform_slit.resolution.x);
+    }
+
+    // -------- Graded mesh: reflection off the grading --------
+    // a pulse runs along a periodic strip from fine cells into cells twice as wide, graded by 1.1 per cell or in
+    // one step. before the reflection comes back the probe in front of the transition sees the same signal on every
+    // mesh, the difference against the uniform mesh is the reflection. the window closes before the absorbing
+    // layer's reflection returns
+    {
+        const int Nx = 700;
+        const int pml = 40;
+        const int source_x = 100;
+        const int probe_x = 150;
+        const int transition_x = 200;
+        const int window = 900;
+
+        auto probe_signal = [&](const std::vector<float>& graded_spacing_x) {
+            FDTDCPU solver;
+            solver.boundary_condition_y = FDTD::Periodic;
+            solver.graded_spacing_x = graded_spacing_x;
+            int resolution_x = graded_spacing_x.empty() ? Nx : (int)graded_spacing_x.size();
+            solver.initialzie_fields([](glm::ivec3, FDTD::ElectroMagneticProperty&) {}, glm::ivec3(resolution_x, 4, 1), glm::ivec2(pml), glm::ivec2(1));
+
+            std::vector<float> signal;
+            for (int n = 0; n < window; ++n) {
+                solver.step();
+                for (int j = 0; j < 4; ++j)
+                    solver.electric_field[solver.get_index(glm::ivec3(source_x, j, 0))] += (float)std::exp(-0.5 * std::pow((n - 60) / 12.0, 2));
+                signal.push_back(solver.electric_field[solver.get_index(glm::ivec3(probe_x, 0, 0))]);
+            }
+            return signal;
+        };
+
+        std::vector<float> graded_spacing_x = FDTD::compute_graded_spacing((float)(Nx * dx), (float)dx, (float)(2 * dx), { glm::vec2(0, transition_x * dx) });
+
+        std::vector<float> step_spacing_x(transition_x, (float)dx);
+        step_spacing_x.resize(transition_x + (Nx - transition_x) / 2, (float)(2 * dx));
+
+        std::vector<float> uniform = probe_signal({});
+        double graded_reflection = relative_difference(uniform, probe_signal(graded_spacing_x));
+        double step_reflection = relative_difference(uniform, probe_signal(step_spacing_x));
+
+        check("graded mesh reflection, 1.1 per cell", graded_reflection, 0.0, 2e-3);
+        check("graded mesh reflection below a single step", graded_reflection, 0.0, step_reflection);
+        printf("[INFO] %-48s %.3g of the incident peak\n", "graded mesh reflection, single step", step_reflection);
+    }
+
+    // -------- Graded mesh: cells of the GPU double slit --------
+    // the scene of ApplicationMainGPU, 2 mm cells around the screen and the slits, 6 mm (a tenth of the
+    // wavelength) in free space, the y axis mirrors about the symmetry plane
+    {
+        std::vector<float> spacing_x = FDTD::compute_graded_spacing(2.048f, 2e-3f, 6e-3f, { glm::vec2(0.78f, 0.83f) });
+        std::vector<float> upper_spacing_y = FDTD::compute_graded_spacing(1.024f, 2e-3f, 6e-3f, { glm::vec2(0.0f, 0.14f) });
+
+        double uniform_cells = 1024.0 * 1024.0;
+        double graded_cells = (double)spacing_x.size() * 2 * upper_spacing_y.size();
+        check("graded gpu double slit, uniform / graded cells", uniform_cells / graded_cells, 6.0, 3.0);
+    }
+
+    // -------- Float reference against a double precision solve --------
+    {
+        const int Nt = equivalence_ticks;
+        const int Nx = point_source.resolution.x;
+        const int Ny = point_source.resolution.y;
+        const int pml = point_source.pml;
+
+        std::vector<double> Ez(Nx * Ny, 0.0), Hx(Nx * Ny, 0.0), Hy(Nx * Ny, 0.0), damp(Nx * Ny, 1.0);
+
+        for (int j = 0; j < Ny; ++j)
+            for (int i = 0; i < Nx; ++i) {
+                double& d = damp[j * Nx + i];
+                if (i <= pml) d *= std::exp(-0.02 * (pml - i));
+                if (Nx - 1 - i <= pml) d *= std::exp(-0.02 * (pml - (Nx - 1 - i)));
+                if (j <= pml) d *= std::exp(-0.02 * (pml - j));
+                if (Ny - 1 - j <= pml) d *= std::exp(-0.02 * (pml - (Ny - 1 - j)));
+            }
+
+        for (int n = 0; n < Nt; ++n) {
+            for (int j = 0; j < Ny - 1; ++j)
+                for (int i = 0; i < Nx - 1; ++i) {
+                    Hx[j * Nx + i] -= (dt / mu0) * (Ez[(j + 1) * Nx + i] - Ez[j * Nx + i]) / dx;
+                    Hy[j * Nx + i] += (dt / mu0) * (Ez[j * Nx + i + 1] - Ez[j * Nx + i]) / dx;
+                }
+
+            for (int j = 0; j < Ny; ++j)
+                for (int i = 0; i < Nx; ++i) {
+                    if (i >= 1 && i < Nx - 1 && j >= 1 && j < Ny - 1) {
+                        Ez[j * Nx + i] += (dt / eps0) *
+                            ((Hy[j * Nx + i] - Hy[j * Nx + i - 1]) / dx -
+                                (Hx[j * Nx + i] - Hx[(j - 1) * Nx + i]) / dx);
+                        if (i == Nx / 2 && j == Ny / 2)
+                            Ez[j * Nx + i] += std::exp(-0.5 * std::pow((n - 40) / 12.0, 2));
+                    }
+                    Ez[j * Nx + i] *= damp[j * Nx + i];
+                }
+        }
+
+        SceneResult reference = run_scene(point_source, FDTDCPU::Reference, Nt, 1, false);
+        std::vector<float> Ez_float(Ez.begin(), Ez.end());
+
+        check("point source float reference vs double", relative_difference(Ez_float, reference.Ez), 0.0, float_to_double_tolerance);
+    }
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+    printf("%d failure(s), %.2f s\n", failure_count, seconds);
+
+    return failure_count == 0 ? 0 : 1;
+}
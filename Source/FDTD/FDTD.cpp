@@ -2,57 +2,441 @@
 #include "Application/ProgramSourcePaths.h"
 #include "PrimitiveRenderer.h"
 
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include <sstream>
+
+namespace {
+	constexpr double c0 = 299792458.0;
+
+	std::string float_to_macro(double value) {
+		std::stringstream stream;
+		stream.precision(9);
+		stream << std::scientific << value;
+		return stream.str();
+	}
+
+	glm::vec4 property_to_vec4(const FDTD::ElectroMagneticProperty& property) {
+		return glm::vec4(property.voxel_type, property.source_frequency, property.source_amplitude, property.source_phase);
+	}
+
+	double compute_axis_length(const std::vector<float>& node_spacing) {
+		return std::accumulate(node_spacing.begin(), node_spacing.end(), 0.0);
+	}
+
+	bool is_same_property(const FDTD::ElectroMagneticProperty& a, const FDTD::ElectroMagneticProperty& b) {
+		return
+			a.voxel_type == b.voxel_type &&
+			a.source_frequency == b.source_frequency &&
+			a.source_amplitude == b.source_amplitude &&
+			a.source_phase == b.source_phase;
+	}
+}
+
 void FDTD::initialzie_fields(
 	std::function<void(glm::ivec3, ElectroMagneticProperty&)> initialization_lambda,
 	glm::ivec3 grid_resolution,
 	glm::ivec2 pml_thickness_x,
 	glm::ivec2 pml_thickness_y,
-	glm::ivec2 pml_thickness_z
+	glm::ivec2 pml_thickness_z,
+	glm::vec3 grid_spacing,
+	float courant_factor
 ) {
 
-	this->grid_resolution = grid_resolution;
+	full_grid_resolution = grid_resolution;
+	symmetry_origin.x = compute_symmetry_origin(symmetry_x, boundary_condition_x, symmetry_plane.x, grid_resolution.x);
+	symmetry_origin.y = compute_symmetry_origin(symmetry_y, boundary_condition_y, symmetry_plane.y, grid_resolution.y);
+	symmetry_origin.z = compute_symmetry_origin(symmetry_z, boundary_condition_z, symmetry_plane.z, grid_resolution.z);
+
+	this->grid_resolution = grid_resolution - symmetry_origin;
 	this->pml_thickness_x = pml_thickness_x;
 	this->pml_thickness_y = pml_thickness_y;
 	this->pml_thickness_z = pml_thickness_z;
+	this->courant_factor = courant_factor != 0 ? courant_factor : compute_default_courant_factor(spatial_order);
+
+	std::vector<float> node_spacing_x = compute_node_spacing(graded_spacing_x, grid_spacing.x, grid_resolution.x);
+	std::vector<float> node_spacing_y = compute_node_spacing(graded_spacing_y, grid_spacing.y, grid_resolution.y);
+
+	// the magnetic component staggered across a symmetry plane is mirrored onto the cell after it
+	if ((symmetry_x != NoSymmetry && node_spacing_x[symmetry_origin.x - 1] != node_spacing_x[symmetry_origin.x]) ||
+		(symmetry_y != NoSymmetry && node_spacing_y[symmetry_origin.y - 1] != node_spacing_y[symmetry_origin.y])
+	) {
+		std::cout << "[FDTD Error] FDTD::initialzie_fields() is called with a graded mesh that does not mirror about the symmetry plane" << std::endl;
+		ASSERT(false);
+	}
+
+	bloch_phase.x = boundary_condition_x != BlochPeriodic ? 0.0f :
+		graded_spacing_x.empty() ? bloch_wavevector.x * grid_resolution.x * grid_spacing.x : bloch_wavevector.x * compute_axis_length(node_spacing_x);
+	bloch_phase.y = boundary_condition_y != BlochPeriodic ? 0.0f :
+		graded_spacing_y.empty() ? bloch_wavevector.y * grid_resolution.y * grid_spacing.y : bloch_wavevector.y * compute_axis_length(node_spacing_y);
+	bloch_phase.z = boundary_condition_z == BlochPeriodic ? bloch_wavevector.z * grid_resolution.z * grid_spacing.z : 0.0f;
+
+	// graded axes are as stable as their finest cell
+	grid_spacing.x = *std::min_element(node_spacing_x.begin(), node_spacing_x.end());
+	grid_spacing.y = *std::min_element(node_spacing_y.begin(), node_spacing_y.end());
+	this->grid_spacing = grid_spacing;
+
+	timestep = compute_stable_timestep(grid_spacing, grid_resolution.z == 1 ? 2 : 3, this->courant_factor, spatial_order);
+
+	// bloch axes carry the imaginary parts next to the real ones: Ez in (re, im), H in (x_re, y_re, x_im, y_im)
+	magnetic_field_internal_format = is_complex() ? Texture3D::ColorTextureFormat::RGBA32F : Texture3D::ColorTextureFormat::RG32F;
 
 	generate_textures();
 
+	std::vector<float> dual_spacing_x = compute_dual_spacing(node_spacing_x, boundary_condition_x != Absorbing);
+	std::vector<float> dual_spacing_y = compute_dual_spacing(node_spacing_y, boundary_condition_y != Absorbing);
+
+	spacing_buffer.assign(std::max(this->grid_resolution.x, this->grid_resolution.y), glm::vec4(0));
+	for (int32_t i = 0; i < this->grid_resolution.x; i++) {
+		spacing_buffer[i].x = node_spacing_x[i + symmetry_origin.x];
+		spacing_buffer[i].y = dual_spacing_x[i + symmetry_origin.x];
+	}
+	for (int32_t i = 0; i < this->grid_resolution.y; i++) {
+		spacing_buffer[i].z = node_spacing_y[i + symmetry_origin.y];
+		spacing_buffer[i].w = dual_spacing_y[i + symmetry_origin.y];
+	}
+
+	spacing_texture->load_data((void*)spacing_buffer.data(), Texture3D::ColorFormat::RGBA, Texture3D::Type::FLOAT, 0);
+
+	// the renderer looks up which cell every screen position falls into, the entry after the last node is the axis length
+	std::vector<float> node_positions_x = compute_node_positions(node_spacing_x);
+	std::vector<float> node_positions_y = compute_node_positions(node_spacing_y);
+	node_positions_x.push_back((float)compute_axis_length(node_spacing_x));
+	node_positions_y.push_back((float)compute_axis_length(node_spacing_y));
+
+	std::vector<glm::vec2> position_buffer(std::max(grid_resolution.x, grid_resolution.y) + 1, glm::vec2(0));
+	for (size_t i = 0; i < node_positions_x.size(); i++)
+		position_buffer[i].x = node_positions_x[i];
+	for (size_t i = 0; i < node_positions_y.size(); i++)
+		position_buffer[i].y = node_positions_y[i];
+
+	position_texture->load_data((void*)position_buffer.data(), Texture3D::ColorFormat::RG, Texture3D::Type::FLOAT, 0);
+
 	electric_field_texture->clear(glm::vec4(0));
 	magnetic_field_texture->clear(glm::vec4(0));
 
-	std::vector<glm::vec4> property_buffer(grid_resolution.x * grid_resolution.y * grid_resolution.z, glm::vec4(0));
+	glm::ivec3 simulated_resolution = this->grid_resolution;
+	property_buffer.assign(simulated_resolution.x * simulated_resolution.y * simulated_resolution.z, glm::vec4(0));
 
-	for (int32_t z = 0; z < grid_resolution.z; z++){
-		for (int32_t y = 0; y < grid_resolution.y; y++){
-			for (int32_t x = 0; x < grid_resolution.x; x++){
+	for (int32_t z = 0; z < simulated_resolution.z; z++){
+		for (int32_t y = 0; y < simulated_resolution.y; y++){
+			for (int32_t x = 0; x < simulated_resolution.x; x++){
 	
 				ElectroMagneticProperty property;
-				initialization_lambda(glm::ivec3(x, y, z), property);
-
-				glm::vec4 property_vec4;
-				property_vec4.x = property.voxel_type;
-				property_vec4.y = property.source_frequency;
-				property_vec4.z = property.source_amplitude;
-				property_vec4.w = property.source_phase;
-				property_buffer[z * grid_resolution.y * grid_resolution.x + y * grid_resolution.x + x] = property_vec4;
+				initialization_lambda(glm::ivec3(x, y, z) + symmetry_origin, property);
+
+				property_buffer[z * simulated_resolution.y * simulated_resolution.x + y * simulated_resolution.x + x] = property_to_vec4(property);
 			}
 		}
 	}
 
 	property_field_texture->load_data((void*)property_buffer.data(), Texture3D::ColorFormat::RGBA, Texture3D::Type::FLOAT, 0);
 
+	// stencil masks need every property in place
+	stencil_buffer.assign(spatial_order == 4 ? property_buffer.size() * 4 : 4, 0);
+
+	if (spatial_order == 4) {
+		for (int32_t y = 0; y < simulated_resolution.y; y++)
+			for (int32_t x = 0; x < simulated_resolution.x; x++)
+				setup_stencil_masks(x, y);
+	}
+
+	stencil_texture->load_data((void*)stencil_buffer.data(), Texture3D::ColorFormat::RGBA, Texture3D::Type::UNSIGNED_BYTE, 0);
+
 	compile_shaders();
 
 }
 
+float FDTD::compute_default_courant_factor(int32_t spatial_order)
+{
+	return spatial_order == 4 ? 0.55f : 0.99f;
+}
+
+float FDTD::compute_stable_timestep(glm::vec3 grid_spacing, int32_t dimentionality, float courant_factor, int32_t spatial_order)
+{
+	if (glm::any(glm::lessThanEqual(grid_spacing, glm::vec3(0))) || courant_factor <= 0 || courant_factor > 1) {
+		std::cout << "[FDTD Error] FDTD::compute_stable_timestep() is called with invalid grid_spacing or courant_factor" << std::endl;
+		ASSERT(false);
+	}
+
+	if (spatial_order != 2 && spatial_order != 4) {
+		std::cout << "[FDTD Error] FDTD::compute_stable_timestep() is called with unsupported spatial_order, only 2 and 4 are supported" << std::endl;
+		ASSERT(false);
+	}
+
+	double inverse_spacing_squared = 0;
+	for (int32_t axis = 0; axis < dimentionality; axis++)
+		inverse_spacing_squared += 1.0 / ((double)grid_spacing[axis] * grid_spacing[axis]);
+
+	// sum of the stencil's coefficient magnitudes, 9/8 + 1/24 for FDTD(2,4)
+	double stencil_gain = spatial_order == 4 ? 7.0 / 6.0 : 1.0;
+
+	return courant_factor / (c0 * stencil_gain * std::sqrt(inverse_spacing_squared));
+}
+
+std::vector<float> FDTD::compute_graded_spacing(float length, float fine_spacing, float coarse_spacing, const std::vector<glm::vec2>& fine_regions, float grading_ratio)
+{
+	if (length <= 0 || fine_spacing <= 0 || coarse_spacing < fine_spacing || grading_ratio < 1) {
+		std::cout << "[FDTD Error] FDTD::compute_graded_spacing() is called with invalid length, spacing or grading_ratio" << std::endl;
+		ASSERT(false);
+	}
+
+	// distance from the cell [begin, end] to the nearest fine region
+	auto distance_to_fine = [&](double begin, double end) {
+		double distance = std::numeric_limits<double>::infinity();
+		for (const glm::vec2& region : fine_regions)
+			distance = std::min(distance, std::max({ 0.0, region.x - end, begin - (double)region.y }));
+		return distance;
+	};
+
+	// cells growing by grading_ratio away from a fine region are fine_spacing + (grading_ratio - 1) * distance wide,
+	// a cell is sized by the distance from both of its ends so it also shrinks on the way into the next region
+	std::vector<float> node_spacing;
+	double position = 0;
+
+	while (position < length) {
+		double spacing = coarse_spacing;
+		for (int32_t i = 0; i < 4; i++)
+			spacing = std::min(spacing, fine_spacing + (grading_ratio - 1.0) * distance_to_fine(position, position + spacing));
+
+		node_spacing.push_back((float)spacing);
+		position += (float)spacing;
+	}
+
+	return node_spacing;
+}
+
+std::vector<float> FDTD::compute_node_positions(const std::vector<float>& node_spacing)
+{
+	std::vector<float> positions(node_spacing.size());
+
+	double position = 0;
+	for (size_t i = 0; i < node_spacing.size(); i++) {
+		positions[i] = (float)position;
+		position += node_spacing[i];
+	}
+
+	return positions;
+}
+
+std::vector<float> FDTD::compute_dual_spacing(const std::vector<float>& node_spacing, bool periodic)
+{
+	const size_t count = node_spacing.size();
+	std::vector<float> dual_spacing(count);
+
+	// the first node of a non periodic axis only has a spacing after it
+	for (size_t i = 0; i < count; i++) {
+		float previous = i > 0 ? node_spacing[i - 1] : periodic ? node_spacing[count - 1] : node_spacing[0];
+		dual_spacing[i] = 0.5f * (previous + node_spacing[i]);
+	}
+
+	return dual_spacing;
+}
+
+std::vector<float> FDTD::compute_node_spacing(const std::vector<float>& graded_spacing, float grid_spacing, int32_t resolution)
+{
+	if (graded_spacing.empty())
+		return std::vector<float>(resolution, grid_spacing);
+
+	if ((int32_t)graded_spacing.size() != resolution || std::any_of(graded_spacing.begin(), graded_spacing.end(), [](float spacing) { return !(spacing > 0); })) {
+		std::cout << "[FDTD Error] FDTD::compute_node_spacing() is called with graded spacing that does not match the grid or is not positive" << std::endl;
+		ASSERT(false);
+	}
+
+	return graded_spacing;
+}
+
+int32_t FDTD::compute_symmetry_origin(Symmetry symmetry, BoundaryCondition boundary_condition, int32_t plane, int32_t resolution)
+{
+	if (symmetry == NoSymmetry)
+		return 0;
+
+	if (plane < 0)
+		plane = resolution / 2;
+
+	if (boundary_condition != Absorbing || plane < 1 || plane > resolution - 2) {
+		std::cout << "[FDTD Error] FDTD::compute_symmetry_origin() is called with a symmetry plane outside the grid or on a periodic axis" << std::endl;
+		ASSERT(false);
+	}
+
+	return plane;
+}
+
+std::vector<FDTD::PropertyPatch> FDTD::compute_property_patches(
+	std::function<void(glm::ivec3, ElectroMagneticProperty&)> previous_lambda,
+	std::function<void(glm::ivec3, ElectroMagneticProperty&)> next_lambda,
+	glm::ivec3 grid_resolution
+) {
+	std::vector<PropertyPatch> patches;
+
+	for (int32_t z = 0; z < grid_resolution.z; z++) {
+		for (int32_t y = 0; y < grid_resolution.y; y++) {
+			for (int32_t x = 0; x < grid_resolution.x; x++) {
+
+				glm::ivec3 id(x, y, z);
+				ElectroMagneticProperty previous_property;
+				ElectroMagneticProperty next_property;
+				previous_lambda(id, previous_property);
+				next_lambda(id, next_property);
+
+				if (!is_same_property(previous_property, next_property))
+					patches.push_back({ id, next_property });
+			}
+		}
+	}
+
+	return patches;
+}
+
+void FDTD::patch_properties(const std::vector<PropertyPatch>& patches)
+{
+	if (property_buffer.empty()) {
+		std::cout << "[FDTD Error] FDTD::patch_properties() is called before initialzie_fields()" << std::endl;
+		ASSERT(false);
+	}
+
+	std::vector<glm::ivec3> patched_cells;
+
+	for (const PropertyPatch& patch : patches) {
+
+		if (glm::any(glm::lessThan(patch.id, glm::ivec3(0))) || glm::any(glm::greaterThanEqual(patch.id, full_grid_resolution))) {
+			std::cout << "[FDTD Error] FDTD::patch_properties() is called with a cell outside the grid" << std::endl;
+			ASSERT(false);
+		}
+
+		glm::ivec3 id = patch.id - symmetry_origin;
+		if (glm::any(glm::lessThan(id, glm::ivec3(0))))
+			continue;
+
+		property_buffer[(size_t)id.z * grid_resolution.y * grid_resolution.x + (size_t)id.y * grid_resolution.x + id.x] = property_to_vec4(patch.property);
+		patched_cells.push_back(id);
+	}
+
+	// a sweep step changes a handful of cells, one upload of the whole buffer is cheaper than one per cell
+	property_field_texture->load_data((void*)property_buffer.data(), Texture3D::ColorFormat::RGBA, Texture3D::Type::FLOAT, 0);
+
+	if (spatial_order != 4)
+		return;
+
+	// the widest taps reach two cells along each axis
+	for (glm::ivec3 id : patched_cells) {
+		for (int32_t y = id.y - 2; y <= id.y + 2; y++) {
+			for (int32_t x = id.x - 2; x <= id.x + 2; x++) {
+
+				int32_t wrapped_x = boundary_condition_x != Absorbing ? (x + grid_resolution.x) % grid_resolution.x : x;
+				int32_t wrapped_y = boundary_condition_y != Absorbing ? (y + grid_resolution.y) % grid_resolution.y : y;
+
+				if (wrapped_x < 0 || wrapped_y < 0 || wrapped_x >= grid_resolution.x || wrapped_y >= grid_resolution.y)
+					continue;
+
+				setup_stencil_masks(wrapped_x, wrapped_y);
+			}
+		}
+	}
+
+	stencil_texture->load_data((void*)stencil_buffer.data(), Texture3D::ColorFormat::RGBA, Texture3D::Type::UNSIGNED_BYTE, 0);
+}
+
+// 255 where the fourth order taps are usable and 0 where the update falls back, same masks as FDTDCPU::setup_stencil_masks()
+void FDTD::setup_stencil_masks(int32_t x, int32_t y)
+{
+	size_t index = (size_t)y * grid_resolution.x + x;
+
+	stencil_buffer[index * 4 + 0] = is_wide_stencil(x, y, glm::ivec2(1, 0), -1, 2) ? 255 : 0;
+	stencil_buffer[index * 4 + 1] = is_wide_stencil(x, y, glm::ivec2(0, 1), -1, 2) ? 255 : 0;
+	stencil_buffer[index * 4 + 2] = is_wide_stencil(x, y, glm::ivec2(1, 0), -2, 2) ? 255 : 0;
+	stencil_buffer[index * 4 + 3] = is_wide_stencil(x, y, glm::ivec2(0, 1), -2, 2) ? 255 : 0;
+}
+
+// cells the fourth order stencil may reach, anything else makes it fall back to the Yee stencil.
+// cells before a symmetry plane are the mirror image of simulated ones, same as FDTDCPU::is_regular_cell()
+bool FDTD::is_regular_cell(int32_t x, int32_t y)
+{
+	if (boundary_condition_x != Absorbing) x = (x + grid_resolution.x) % grid_resolution.x;
+	if (boundary_condition_y != Absorbing) y = (y + grid_resolution.y) % grid_resolution.y;
+	if (symmetry_x != NoSymmetry && x < 0) x = -x;
+	if (symmetry_y != NoSymmetry && y < 0) y = -y;
+
+	if (x < 0 || y < 0 || x >= grid_resolution.x || y >= grid_resolution.y)
+		return false;
+
+	float voxel_type = property_buffer[(size_t)y * grid_resolution.x + x].x;
+	return voxel_type != PEC && voxel_type != SourceSinosoidal && !is_in_absorbing_layer(x, y);
+}
+
+// the near side of a symmetric axis is the symmetry plane, not a boundary
+bool FDTD::is_in_absorbing_layer(int32_t x, int32_t y)
+{
+	return
+		(boundary_condition_x == Absorbing && ((symmetry_x == NoSymmetry && x <= pml_thickness_x.x) || grid_resolution.x - 1 - x <= pml_thickness_x.y)) ||
+		(boundary_condition_y == Absorbing && ((symmetry_y == NoSymmetry && y <= pml_thickness_y.x) || grid_resolution.y - 1 - y <= pml_thickness_y.y));
+}
+
+// all cells from (x, y) + first * direction to (x, y) + last * direction are regular and evenly spaced
+bool FDTD::is_wide_stencil(int32_t x, int32_t y, glm::ivec2 direction, int32_t first, int32_t last)
+{
+	for (int32_t i = first; i <= last; i++)
+		if (!is_regular_cell(x + i * direction.x, y + i * direction.y))
+			return false;
+
+	int32_t resolution = direction.x != 0 ? grid_resolution.x : grid_resolution.y;
+	int32_t along = direction.x != 0 ? x : y;
+	bool symmetric = (direction.x != 0 ? symmetry_x : symmetry_y) != NoSymmetry;
+	auto node_spacing = [&](int32_t i) {
+		i += along;
+		const glm::vec4& spacing = spacing_buffer[symmetric && i < 0 ? -i - 1 : (i + resolution) % resolution];
+		return direction.x != 0 ? spacing.x : spacing.z;
+	};
+
+	for (int32_t i = first + 1; i < last; i++)
+		if (node_spacing(i) != node_spacing(first))
+			return false;
+
+	return true;
+}
+
+void FDTD::load_field_state(const FieldState& state)
+{
+	if (state.grid_resolution != grid_resolution || state.is_complex() != is_complex()) {
+		std::cout << "[FDTD Error] FDTD::load_field_state() is called with a state of another grid" << std::endl;
+		ASSERT(false);
+	}
+
+	size_t cell_count = (size_t)grid_resolution.x * grid_resolution.y * grid_resolution.z;
+	std::vector<glm::vec4> electric_buffer(cell_count, glm::vec4(0));
+	std::vector<glm::vec4> magnetic_buffer(cell_count, glm::vec4(0));
+
+	// same layout as the textures: Ez in (re, im), H in (x_re, y_re, x_im, y_im)
+	for (size_t i = 0; i < cell_count; i++) {
+		electric_buffer[i].x = state.electric_field[i];
+		magnetic_buffer[i].x = state.magnetic_field_x[i];
+		magnetic_buffer[i].y = state.magnetic_field_y[i];
+
+		if (state.is_complex()) {
+			electric_buffer[i].y = state.electric_field_imaginary[i];
+			magnetic_buffer[i].z = state.magnetic_field_x_imaginary[i];
+			magnetic_buffer[i].w = state.magnetic_field_y_imaginary[i];
+		}
+	}
+
+	electric_field_texture->load_data((void*)electric_buffer.data(), Texture3D::ColorFormat::RGBA, Texture3D::Type::FLOAT, 0);
+	magnetic_field_texture->load_data((void*)magnetic_buffer.data(), Texture3D::ColorFormat::RGBA, Texture3D::Type::FLOAT, 0);
+
+	// pacing restarts from the loaded tick instead of catching up from 0
+	tick = state.tick;
+	paced_tick_begin = state.tick;
+}
+
 void FDTD::iterate_time(float target_tick_per_second)
 {
-	if (tick == 0) {
+	if (tick == paced_tick_begin) {
 		simulation_begin = std::chrono::system_clock::now();
 	}
 
 	size_t targeted_tick_count = target_tick_per_second * get_total_time_elapsed().count() / 1000.0f;
-	if (target_tick_per_second <= 0 || tick < targeted_tick_count || tick == 0) {
+	if (target_tick_per_second <= 0 || tick - paced_tick_begin < targeted_tick_count || tick == paced_tick_begin) {
 
 		step();
 
@@ -67,8 +451,14 @@ void FDTD::step() {
 		kernel.update_uniform_as_image("electric_texture", *electric_field_texture, 0);
 		kernel.update_uniform_as_image("magnetic_texture", *magnetic_field_texture, 0);
 		kernel.update_uniform_as_image("property_texture", *property_field_texture, 0);
+		kernel.update_uniform_as_image("spacing_texture", *spacing_texture, 0);
+		kernel.update_uniform_as_image("stencil_texture", *stencil_texture, 0);
 	
 		kernel.update_uniform("grid_resolution", grid_resolution);
+		kernel.update_uniform("pml_thickness_x", pml_thickness_x);
+		kernel.update_uniform("pml_thickness_y", pml_thickness_y);
+		kernel.update_uniform("pml_thickness_z", pml_thickness_z);
+		kernel.update_uniform("bloch_phase", bloch_phase);
 	
 		kernel.dispatch_thread(grid_resolution);
 	}
@@ -79,11 +469,14 @@ void FDTD::step() {
 		kernel.update_uniform_as_image("electric_texture", *electric_field_texture, 0);
 		kernel.update_uniform_as_image("magnetic_texture", *magnetic_field_texture, 0);
 		kernel.update_uniform_as_image("property_texture", *property_field_texture, 0);
+		kernel.update_uniform_as_image("spacing_texture", *spacing_texture, 0);
+		kernel.update_uniform_as_image("stencil_texture", *stencil_texture, 0);
 		
 		kernel.update_uniform("grid_resolution", grid_resolution);
 		kernel.update_uniform("pml_thickness_x", pml_thickness_x);
 		kernel.update_uniform("pml_thickness_y", pml_thickness_y);
 		kernel.update_uniform("pml_thickness_z", pml_thickness_z);
+		kernel.update_uniform("bloch_phase", bloch_phase);
 
 		kernel.update_uniform("tick", tick);
 	
@@ -103,6 +496,36 @@ std::chrono::duration<double, std::milli> FDTD::get_total_time_elapsed()
 	return std::chrono::system_clock::now() - simulation_begin;
 }
 
+glm::vec3 FDTD::get_grid_spacing()
+{
+	return grid_spacing;
+}
+
+float FDTD::get_timestep()
+{
+	return timestep;
+}
+
+glm::ivec3 FDTD::get_grid_resolution()
+{
+	return grid_resolution;
+}
+
+glm::ivec3 FDTD::get_full_grid_resolution()
+{
+	return full_grid_resolution;
+}
+
+bool FDTD::is_complex()
+{
+	return boundary_condition_x == BlochPeriodic || boundary_condition_y == BlochPeriodic || boundary_condition_z == BlochPeriodic;
+}
+
+bool FDTD::is_graded()
+{
+	return !graded_spacing_x.empty() || !graded_spacing_y.empty();
+}
+
 void FDTD::render2d_electromagnetic()
 {
 	Program& program = *program_render2d_electromagnetic;
@@ -110,11 +533,20 @@ void FDTD::render2d_electromagnetic()
 	program.update_uniform("electric_texture", *electric_field_texture);
 	program.update_uniform("magnetic_texture", *magnetic_field_texture);
 	program.update_uniform("property_texture", *property_field_texture);
+	program.update_uniform("position_texture", *position_texture);
+	program.update_uniform("graded_mesh", is_graded() ? 1 : 0);
 
 	program.update_uniform("model", glm::identity<glm::mat4>());
 	program.update_uniform("view", glm::identity<glm::mat4>());
 	program.update_uniform("projection", glm::identity<glm::mat4>());
 	program.update_uniform("texture_resolution", glm::vec3(electric_field_texture->get_size()));
+	program.update_uniform("full_grid_resolution", glm::vec3(full_grid_resolution));
+	program.update_uniform("symmetry_origin", glm::vec3(symmetry_origin));
+	program.update_uniform("symmetry_sign", glm::vec3(
+		symmetry_x == NoSymmetry ? 0 : symmetry_x == EvenSymmetry ? 1 : -1,
+		symmetry_y == NoSymmetry ? 0 : symmetry_y == EvenSymmetry ? 1 : -1,
+		symmetry_z == NoSymmetry ? 0 : symmetry_z == EvenSymmetry ? 1 : -1
+	));
 	program.update_uniform("render_depth", 0);
 
 	RenderParameters params(true);
@@ -134,7 +566,21 @@ std::vector<std::pair<std::string, std::string>> FDTD::generate_macros() {
 		{"fdtd_electric_internal_format",		Texture3D::ColorTextureFormat_to_OpenGL_compute_Image_format(electric_field_internal_format)},
 		{"fdtd_magnetic_internal_format",		Texture3D::ColorTextureFormat_to_OpenGL_compute_Image_format(magnetic_field_internal_format)},
 		{"fdtd_property_internal_format",		Texture3D::ColorTextureFormat_to_OpenGL_compute_Image_format(property_field_internal_format)},
+		{"fdtd_stencil_internal_format",		Texture3D::ColorTextureFormat_to_OpenGL_compute_Image_format(stencil_internal_format)},
 		{"dimentionality",						grid_resolution.z == 1 ? "2" : "3"},
+		{"grid_spacing_x",						float_to_macro(grid_spacing.x)},
+		{"grid_spacing_y",						float_to_macro(grid_spacing.y)},
+		{"grid_spacing_z",						float_to_macro(grid_spacing.z)},
+		{"timestep",							float_to_macro(timestep)},
+		{"boundary_x",							std::to_string(boundary_condition_x)},
+		{"boundary_y",							std::to_string(boundary_condition_y)},
+		{"boundary_z",							std::to_string(boundary_condition_z)},
+		{"complex_fields",						is_complex() ? "1" : "0"},
+		{"symmetry_x",							std::to_string(symmetry_x)},
+		{"symmetry_y",							std::to_string(symmetry_y)},
+		{"symmetry_z",							std::to_string(symmetry_z)},
+		{"spatial_order",						std::to_string(spatial_order)},
+		{"graded_mesh",							is_graded() ? "1" : "0"},
 	};
 
 	return definitions;
@@ -289,9 +735,9 @@ void FDTD::generate_textures() {
 		ASSERT(false);
 	}
 
-	if (glm::any(glm::lessThanEqual(pml_thickness_x, glm::ivec2(0))) ||
-		glm::any(glm::lessThanEqual(pml_thickness_y, glm::ivec2(0))) ||
-		glm::any(glm::lessThanEqual(pml_thickness_y, glm::ivec2(0)))
+	if ((boundary_condition_x == Absorbing && glm::any(glm::lessThanEqual(pml_thickness_x, glm::ivec2(0)))) ||
+		(boundary_condition_y == Absorbing && glm::any(glm::lessThanEqual(pml_thickness_y, glm::ivec2(0)))) ||
+		(boundary_condition_z == Absorbing && grid_resolution.z != 1 && glm::any(glm::lessThanEqual(pml_thickness_z, glm::ivec2(0))))
 	) {
 
 		std::cout << "[FDTD Error] FDTD::generate_textures() is called with invalid pml_thickness" << std::endl;
@@ -314,5 +760,22 @@ void FDTD::generate_textures() {
 		property_field_internal_format, 1, 0
 	);
 
+	spacing_texture = std::make_shared<Texture3D>(
+		std::max(grid_resolution.x, grid_resolution.y), 1, 1,
+		spacing_internal_format, 1, 0
+	);
+
+	position_texture = std::make_shared<Texture3D>(
+		std::max(full_grid_resolution.x, full_grid_resolution.y) + 1, 1, 1,
+		position_internal_format, 1, 0
+	);
+
+	// a single texel when the Yee stencil never reads the masks
+	glm::ivec3 stencil_resolution = spatial_order == 4 ? grid_resolution : glm::ivec3(1);
+	stencil_texture = std::make_shared<Texture3D>(
+		stencil_resolution.x, stencil_resolution.y, stencil_resolution.z,
+		stencil_internal_format, 1, 0
+	);
+
 
 }
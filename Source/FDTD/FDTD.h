@@ -1,6 +1,7 @@
 #pragma once
 
 #include "ComputeProgram.h"
+#include "FieldState.h"
 #include <memory>
 
 #include "Texture3D.h"
@@ -14,29 +15,123 @@ public:
 		PEC					= 1,
 		SourceSinosoidal	= 2,
 		SourceImpulse		= 3,
+		SourceSinosoidalSoft	= 4,
+	};
+
+	enum BoundaryCondition {
+		Absorbing		= 0,
+		Periodic		= 1,
+		BlochPeriodic	= 2,
+	};
+
+	// parity of Ez across a symmetry plane, Even acts as a PMC wall and Odd as a PEC wall
+	enum Symmetry {
+		NoSymmetry		= 0,
+		EvenSymmetry	= 1,
+		OddSymmetry		= 2,
 	};
 
 	struct ElectroMagneticProperty {
 		VoxelType voxel_type = Normal;
-		float source_frequency = 1;
+		float source_frequency = 1;		// Hz
 		float source_amplitude = 1;
 		float source_phase = 0;
 	};
 
+	// one changed cell for patch_properties(), id in full grid coordinates as initialization_lambda sees them
+	struct PropertyPatch {
+		glm::ivec3 id;
+		ElectroMagneticProperty property;
+	};
+
+	// set before initialzie_fields(), periodic axes ignore their pml_thickness.
+	// BlochPeriodic axes satisfy E(r + L) = E(r) * exp(-i * k.L) and switch to complex fields,
+	// the imaginary parts are driven by the quadrature of every sinusoidal source.
+	BoundaryCondition boundary_condition_x = Absorbing;
+	BoundaryCondition boundary_condition_y = Absorbing;
+	BoundaryCondition boundary_condition_z = Absorbing;
+	glm::vec3 bloch_wavevector = glm::vec3(0);		// rad/m
+
+	// set before initialzie_fields(), only the cells from the symmetry plane to the far edge are simulated,
+	// halving memory and work per symmetric axis. initialization_lambda still sees full grid coordinates
+	// and the renderer shows the mirrored half. planes pass through Ez nodes, -1 places them at grid_resolution / 2.
+	Symmetry symmetry_x = NoSymmetry;
+	Symmetry symmetry_y = NoSymmetry;
+	Symmetry symmetry_z = NoSymmetry;
+	glm::ivec3 symmetry_plane = glm::ivec3(-1);
+
+	// set before initialzie_fields(), 2 for the Yee stencil or 4 for FDTD(2,4). the fourth order stencil falls back
+	// to second order wherever its taps would reach into PEC, hard sources, the absorbing layer or past the grid
+	int32_t spatial_order = 2;
+
+	// set before initialzie_fields(), graded rectilinear mesh. entry i is the distance in meters from Ez node i to
+	// node i + 1 of the full grid, on periodic axes the last entry reaches the first node of the next period.
+	// empty keeps grid_spacing on that axis, otherwise there is one entry per cell of the axis. the timestep follows
+	// the finest spacing, the fourth order stencil falls back to second order where the spacing under its taps
+	// changes and symmetric axes need a mesh that mirrors about the plane
+	std::vector<float> graded_spacing_x;
+	std::vector<float> graded_spacing_y;
+
 	void initialzie_fields(
 		std::function<void(glm::ivec3, ElectroMagneticProperty&)> initialization_lambda,
 		glm::ivec3 grid_resolution,
 		glm::ivec2 pml_thickness_x = glm::ivec2(10),
 		glm::ivec2 pml_thickness_y = glm::ivec2(10),
-		glm::ivec2 pml_thickness_z = glm::ivec2(10)
+		glm::ivec2 pml_thickness_z = glm::ivec2(10),
+		glm::vec3 grid_spacing = glm::vec3(2e-3f),
+		float courant_factor = 0			// 0 picks compute_default_courant_factor(spatial_order)
 	);
 
+	// 0.99 for the Yee stencil. FDTD(2,4)'s spatial error is small enough that the leapfrog time error dominates
+	// near its stability limit, at 0.55 the two partly cancel and N / 2 cells per wavelength disperse less than
+	// the Yee stencil at N (for N >= 10) in about as many steps
+	static float compute_default_courant_factor(int32_t spatial_order);
+
+	// largest stable timestep of the Yee scheme scaled by courant_factor (<= 1),
+	// the fourth order stencil's wider spatial operator lowers it by 6/7
+	static float compute_stable_timestep(glm::vec3 grid_spacing, int32_t dimentionality, float courant_factor, int32_t spatial_order = 2);
+
+	// node spacing of an axis covering at least length meters: fine_spacing inside fine_regions ((begin, end) in meters)
+	// and growing by grading_ratio per cell up to coarse_spacing away from them, so the grading reflects little
+	static std::vector<float> compute_graded_spacing(float length, float fine_spacing, float coarse_spacing, const std::vector<glm::vec2>& fine_regions, float grading_ratio = 1.1f);
+
+	// meters from node 0 to every node of an axis
+	static std::vector<float> compute_node_positions(const std::vector<float>& node_spacing);
+
+	// distance between the magnetic nodes around every Ez node, halfway to the nodes on both sides
+	static std::vector<float> compute_dual_spacing(const std::vector<float>& node_spacing, bool periodic);
+
+	// node spacing of an axis, graded_spacing or grid_spacing repeated over the axis
+	static std::vector<float> compute_node_spacing(const std::vector<float>& graded_spacing, float grid_spacing, int32_t resolution);
+
+	// first simulated cell along an axis, the symmetry plane or 0 for axes without symmetry
+	static int32_t compute_symmetry_origin(Symmetry symmetry, BoundaryCondition boundary_condition, int32_t plane, int32_t resolution);
+
+	// every cell of the full grid where next_lambda sets a different property than previous_lambda
+	static std::vector<PropertyPatch> compute_property_patches(
+		std::function<void(glm::ivec3, ElectroMagneticProperty&)> previous_lambda,
+		std::function<void(glm::ivec3, ElectroMagneticProperty&)> next_lambda,
+		glm::ivec3 grid_resolution
+	);
+
+	// rewrites the changed cells of the property texture in place, fields, tick, textures and shaders are kept.
+	// cells before a symmetry plane are skipped, they are mirror images of simulated ones
+	void patch_properties(const std::vector<PropertyPatch>& patches);
+
+	// continues from fields saved on the same simulated grid, e.g. by FDTDCPU::get_field_state(), tick included
+	void load_field_state(const FieldState& state);
+
 	void iterate_time(float target_tick_per_second);
 
 	void render2d_electromagnetic();
 
 	int32_t get_total_ticks_elapsed();
 	std::chrono::duration<double, std::milli> get_total_time_elapsed();
+	glm::vec3 get_grid_spacing();			// finest spacing on graded axes
+	float get_timestep();
+	bool is_complex();
+	glm::ivec3 get_grid_resolution();		// simulated cells, smaller than the requested grid on symmetric axes
+	glm::ivec3 get_full_grid_resolution();
 
 	std::shared_ptr<Texture3D>	electric_field_texture;
 	std::shared_ptr<Texture3D>	magnetic_field_texture;
@@ -45,11 +140,23 @@ public:
 private:
 
 	void step();
+	bool is_graded();
+
+	void setup_stencil_masks(int32_t x, int32_t y);
+	bool is_regular_cell(int32_t x, int32_t y);
+	bool is_in_absorbing_layer(int32_t x, int32_t y);
+	bool is_wide_stencil(int32_t x, int32_t y, glm::ivec2 direction, int32_t first, int32_t last);
 
 	glm::ivec3 grid_resolution = glm::ivec3(0);
+	glm::ivec3 full_grid_resolution = glm::ivec3(0);
+	glm::ivec3 symmetry_origin = glm::ivec3(0);
 	glm::ivec2 pml_thickness_x = glm::ivec2(0);
 	glm::ivec2 pml_thickness_y = glm::ivec2(0);
 	glm::ivec2 pml_thickness_z = glm::ivec2(0);
+	glm::vec3 grid_spacing = glm::vec3(0);
+	float courant_factor = 0;
+	float timestep = 0;
+	glm::vec3 bloch_phase = glm::vec3(0);
 
 	std::vector<std::pair<std::string, std::string>> generate_macros();
 	void compile_shaders();
@@ -59,7 +166,26 @@ private:
 	Texture3D::ColorTextureFormat magnetic_field_internal_format = Texture3D::ColorTextureFormat::RG32F;
 	Texture3D::ColorTextureFormat property_field_internal_format = Texture3D::ColorTextureFormat::RGBA32F;
 
+	// cpu copy of property_field_texture, patches are applied here and uploaded again
+	std::vector<glm::vec4> property_buffer;
+
+	// (node spacing x, dual spacing x, node spacing y, dual spacing y) per column and row of the simulated grid
+	std::vector<glm::vec4> spacing_buffer;
+	std::shared_ptr<Texture3D> spacing_texture;
+	Texture3D::ColorTextureFormat spacing_internal_format = Texture3D::ColorTextureFormat::RGBA32F;
+
+	// (node position x, node position y) in meters per column and row of the full grid, for the renderer
+	std::shared_ptr<Texture3D> position_texture;
+	Texture3D::ColorTextureFormat position_internal_format = Texture3D::ColorTextureFormat::RG32F;
+
+	// (magnetic wide x, magnetic wide y, electric wide x, electric wide y) per cell, set where the fourth order taps
+	// are usable. kept up to date by initialzie_fields() and patch_properties() so the kernels read one texel per cell
+	std::vector<uint8_t> stencil_buffer;
+	std::shared_ptr<Texture3D> stencil_texture;
+	Texture3D::ColorTextureFormat stencil_internal_format = Texture3D::ColorTextureFormat::RGBA8;
+
 	int32_t tick = 0;
+	int32_t paced_tick_begin = 0;
 	std::chrono::time_point<std::chrono::system_clock> simulation_begin;
 
 	std::shared_ptr<ComputeProgram> cp_magnetic_update;
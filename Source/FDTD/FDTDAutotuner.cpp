@@ -0,0 +1,229 @@
+#include "FDTDAutotuner.h"
+#include "GraphicsCortex.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#endif
+
+namespace {
+	std::string trim(const std::string& text) {
+		size_t begin = text.find_first_not_of(" \t\r\n");
+		size_t end = text.find_last_not_of(" \t\r\n");
+		return begin == std::string::npos ? "" : text.substr(begin, end - begin + 1);
+	}
+
+	std::vector<std::string> split_fields(const std::string& line) {
+		std::vector<std::string> fields;
+		std::stringstream stream(line);
+		std::string field;
+		while (std::getline(stream, field, '|'))
+			fields.push_back(trim(field));
+		return fields;
+	}
+}
+
+std::string FDTDAutotuner::get_cpu_model()
+{
+	char brand[49] = {};
+
+#if defined(_MSC_VER)
+	int registers[4];
+	__cpuid(registers, 0x80000000);
+	if ((unsigned int)registers[0] >= 0x80000004)
+		for (int32_t i = 0; i < 3; i++) {
+			__cpuid(registers, 0x80000002 + i);
+			std::memcpy(brand + 16 * i, registers, 16);
+		}
+#elif defined(__x86_64__) || defined(__i386__)
+	unsigned int registers[4];
+	if (__get_cpuid_max(0x80000000, nullptr) >= 0x80000004)
+		for (int32_t i = 0; i < 3; i++) {
+			__get_cpuid(0x80000002 + i, &registers[0], &registers[1], &registers[2], &registers[3]);
+			std::memcpy(brand + 16 * i, registers, 16);
+		}
+#endif
+
+	std::string model = trim(brand);
+	if (model.empty())
+		model = "unknown cpu";
+
+	// '|' separates the profile fields
+	for (char& c : model)
+		if (c == '|') c = ' ';
+
+	return model + ", " + std::to_string(WorkerPool::get_hardware_thread_count()) + " threads";
+}
+
+std::string FDTDAutotuner::get_grid_class(FDTDCPU& solver)
+{
+	glm::ivec3 resolution = solver.get_grid_resolution();
+	size_t cell_count = (size_t)resolution.x * resolution.y * resolution.z;
+
+	int32_t exponent = 0;
+	while (((size_t)2 << exponent) <= cell_count)
+		exponent++;
+
+	std::string grid_class = "2^" + std::to_string(exponent) + " cells, order " + std::to_string(solver.spatial_order) + (solver.is_complex() ? ", complex" : ", real");
+
+	// ensembles move several members per cell, their best tiles differ from single runs
+	if (solver.get_ensemble_size() > 1)
+		grid_class += ", ensemble " + std::to_string(solver.get_ensemble_size());
+
+	return grid_class;
+}
+
+std::vector<FDTDAutotuner::Configuration> FDTDAutotuner::get_candidates(int32_t hardware_thread_count)
+{
+	std::vector<Configuration> candidates;
+
+	Configuration vectorized;
+	vectorized.kernel_variant = FDTDCPU::Vectorized;
+	candidates.push_back(vectorized);
+
+	// tiles only pay off through threads, whole rows keep the streams long and narrow tiles keep them in cache
+	const glm::ivec2 tile_sizes[] = {
+		glm::ivec2(0, 4), glm::ivec2(0, 16), glm::ivec2(0, 64),
+		glm::ivec2(256, 16), glm::ivec2(256, 64), glm::ivec2(64, 64),
+	};
+
+	for (int32_t thread_count = 2; thread_count < 2 * hardware_thread_count; thread_count *= 2) {
+		for (glm::ivec2 tile_size : tile_sizes) {
+			Configuration tiled;
+			tiled.kernel_variant = FDTDCPU::Tiled;
+			tiled.tile_size = tile_size;
+			tiled.thread_count = std::min(thread_count, hardware_thread_count);
+			candidates.push_back(tiled);
+		}
+
+		if (thread_count >= hardware_thread_count)
+			break;
+	}
+
+	return candidates;
+}
+
+FDTDAutotuner::Configuration FDTDAutotuner::tune(const FDTDCPU& solver, int32_t calibration_ticks)
+{
+	if (calibration_ticks <= 0) {
+		std::cout << "[FDTD Error] FDTDAutotuner::tune() is called with invalid calibration_ticks" << std::endl;
+		ASSERT(false);
+	}
+
+	FDTDCPU calibration = solver;
+
+	glm::ivec3 resolution = calibration.get_grid_resolution();
+	double cell_count = (double)resolution.x * resolution.y * resolution.z;
+
+	Configuration best;
+
+	for (Configuration candidate : get_candidates(WorkerPool::get_hardware_thread_count())) {
+
+		apply(calibration, candidate);
+
+		// the first tick spins up the worker pool and warms the caches
+		calibration.step();
+
+		auto begin = std::chrono::steady_clock::now();
+		calibration.iterate_time(calibration_ticks);
+		double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+		candidate.cells_per_second = cell_count * calibration_ticks / std::max(seconds, 1e-9);
+
+		if (candidate.cells_per_second > best.cells_per_second)
+			best = candidate;
+	}
+
+	return best;
+}
+
+void FDTDAutotuner::apply(FDTDCPU& solver, const Configuration& configuration)
+{
+	solver.kernel_variant = configuration.kernel_variant;
+	solver.tile_size = configuration.tile_size;
+	solver.thread_count = configuration.thread_count;
+}
+
+bool FDTDAutotuner::load_profile(const std::string& path, const std::string& cpu_model, const std::string& grid_class, Configuration& configuration)
+{
+	std::ifstream file(path);
+	if (!file)
+		return false;
+
+	std::string line;
+	while (std::getline(file, line)) {
+
+		if (trim(line).empty() || trim(line)[0] == '#')
+			continue;
+
+		std::vector<std::string> fields = split_fields(line);
+		if (fields.size() != 7 || fields[0] != cpu_model || fields[1] != grid_class)
+			continue;
+
+		// a malformed entry counts as missing so the grid is tuned again and save_profile() replaces it
+		int32_t kernel_variant;
+		Configuration parsed;
+		try {
+			kernel_variant = std::stoi(fields[2]);
+			parsed.tile_size = glm::ivec2(std::stoi(fields[3]), std::stoi(fields[4]));
+			parsed.thread_count = std::stoi(fields[5]);
+			parsed.cells_per_second = std::stod(fields[6]);
+		}
+		catch (const std::exception&) {
+			std::cout << "[FDTD Error] FDTDAutotuner::load_profile() found a malformed entry in " << path << std::endl;
+			return false;
+		}
+
+		if (kernel_variant != FDTDCPU::Vectorized && kernel_variant != FDTDCPU::Tiled) {
+			std::cout << "[FDTD Error] FDTDAutotuner::load_profile() found an invalid kernel variant in " << path << std::endl;
+			return false;
+		}
+
+		parsed.kernel_variant = (FDTDCPU::KernelVariant)kernel_variant;
+		configuration = parsed;
+		return true;
+	}
+
+	return false;
+}
+
+void FDTDAutotuner::save_profile(const std::string& path, const std::string& cpu_model, const std::string& grid_class, const Configuration& configuration)
+{
+	std::vector<std::string> lines;
+	{
+		std::ifstream file(path);
+		std::string line;
+		while (std::getline(file, line)) {
+			std::vector<std::string> fields = split_fields(line);
+			if (fields.size() >= 2 && fields[0] == cpu_model && fields[1] == grid_class)
+				continue;
+			lines.push_back(line);
+		}
+	}
+
+	if (lines.empty())
+		lines.push_back("# cpu model | grid class | kernel variant | tile x | tile y | threads | cells per second");
+
+	std::stringstream entry;
+	entry << cpu_model << " | " << grid_class << " | " << (int32_t)configuration.kernel_variant << " | "
+		<< configuration.tile_size.x << " | " << configuration.tile_size.y << " | " << configuration.thread_count << " | "
+		<< (int64_t)configuration.cells_per_second;
+	lines.push_back(entry.str());
+
+	std::ofstream file(path, std::ios::trunc);
+	if (!file) {
+		std::cout << "[FDTD Error] FDTDAutotuner::save_profile() cannot write " << path << std::endl;
+		ASSERT(false);
+	}
+
+	for (const std::string& line : lines)
+		file << line << "\n";
+}
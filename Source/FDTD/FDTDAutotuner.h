@@ -0,0 +1,42 @@
+#pragma once
+
+#include "FDTDCPU.h"
+
+#include <string>
+#include <vector>
+
+// picks the fastest kernel variant, tile shape and thread count of FDTDCPU for this machine and grid.
+// every candidate runs a short calibration on a copy of an initialized solver, the winner is stored
+// in a plain text profile keyed by cpu model and grid class:
+//   cpu model | grid class | kernel variant | tile x | tile y | threads | cells per second
+// several machines can share one profile file, each reads back only its own entries.
+
+class FDTDAutotuner {
+public:
+
+	struct Configuration {
+		FDTDCPU::KernelVariant kernel_variant = FDTDCPU::Vectorized;
+		glm::ivec2 tile_size = glm::ivec2(0, 16);
+		int32_t thread_count = 1;
+		double cells_per_second = 0;
+	};
+
+	// cpuid brand string and hardware thread count, "unknown cpu" where cpuid is unavailable
+	static std::string get_cpu_model();
+
+	// simulated cell count rounded down to a power of two, spatial order, real or complex fields and the ensemble size
+	static std::string get_grid_class(FDTDCPU& solver);
+
+	static std::vector<Configuration> get_candidates(int32_t hardware_thread_count);
+
+	// the solver is copied, its fields and tick count are left untouched
+	static Configuration tune(const FDTDCPU& solver, int32_t calibration_ticks = 16);
+
+	static void apply(FDTDCPU& solver, const Configuration& configuration);
+
+	// returns false if the file or a matching entry is missing
+	static bool load_profile(const std::string& path, const std::string& cpu_model, const std::string& grid_class, Configuration& configuration);
+
+	// replaces the entry with the same cpu model and grid class, other entries are kept
+	static void save_profile(const std::string& path, const std::string& cpu_model, const std::string& grid_class, const Configuration& configuration);
+};
@@ -0,0 +1,1240 @@
+#include "FDTDCPU.h"
+#include "FDTDAutotuner.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+namespace {
+	constexpr double pi		= 3.14159265358979323846264338327950288;
+	constexpr double eps0	= 8.854187817e-12;
+	constexpr double mu0	= 4.0 * pi * 1e-7;
+
+	// imaginary part is the quadrature of the real one so complex fields are driven by exp(i * w * t)
+	float sinusoidal_source_value(float frequency, float amplitude, float phase, int32_t tick, float dt, int32_t part) {
+		double angle = 2.0 * pi * frequency * tick * dt + phase;
+		return (float)(part == 0 ? std::sin(angle) : -std::cos(angle)) * amplitude;
+	}
+
+	float impulse_source_value(int32_t tick, int32_t part) {
+		return part == 0 ? std::exp(-0.5f * std::pow((tick - 40) / 12.0f, 2.0f)) : 0.0f;
+	}
+
+	// the ensemble members of one cell. gcc and clang map them onto a simd vector of lane_count floats, other
+	// compilers get a fixed size array the auto vectorizer can unroll. a single lane stays a float so the row
+	// sweeps keep vectorizing along x
+#if defined(__GNUC__)
+	template<int32_t lane_count>
+	struct LaneVectorType {
+		typedef float type __attribute__((vector_size(sizeof(float) * lane_count), aligned(sizeof(float)), may_alias));
+	};
+#else
+	template<int32_t lane_count>
+	struct LaneArray {
+		float lane[lane_count];
+
+		LaneArray operator+(const LaneArray& other) const { LaneArray result; for (int32_t i = 0; i < lane_count; i++) result.lane[i] = lane[i] + other.lane[i]; return result; }
+		LaneArray operator-(const LaneArray& other) const { LaneArray result; for (int32_t i = 0; i < lane_count; i++) result.lane[i] = lane[i] - other.lane[i]; return result; }
+		friend LaneArray operator*(float scale, const LaneArray& value) { LaneArray result; for (int32_t i = 0; i < lane_count; i++) result.lane[i] = scale * value.lane[i]; return result; }
+	};
+
+	template<int32_t lane_count>
+	struct LaneVectorType {
+		typedef LaneArray<lane_count> type;
+	};
+#endif
+
+	template<>
+	struct LaneVectorType<1> {
+		typedef float type;
+	};
+
+	template<int32_t lane_count>
+	using LaneVector = typename LaneVectorType<lane_count>::type;
+
+	// the lanes of the cell starting at cell, only as aligned as a float
+	template<int32_t lane_count>
+	const LaneVector<lane_count>& lanes_at(const float* cell) {
+		return *reinterpret_cast<const LaneVector<lane_count>*>(cell);
+	}
+
+	template<int32_t lane_count>
+	LaneVector<lane_count>& lanes_at(float* cell) {
+		return *reinterpret_cast<LaneVector<lane_count>*>(cell);
+	}
+}
+
+void FDTDCPU::initialzie_fields(
+	std::function<void(glm::ivec3, FDTD::ElectroMagneticProperty&)> initialization_lambda,
+	glm::ivec3 grid_resolution,
+	glm::ivec2 pml_thickness_x,
+	glm::ivec2 pml_thickness_y,
+	glm::ivec2 pml_thickness_z,
+	glm::vec3 grid_spacing,
+	float courant_factor
+) {
+	initialzie_fields(
+		std::vector<std::function<void(glm::ivec3, FDTD::ElectroMagneticProperty&)>>{ initialization_lambda },
+		grid_resolution, pml_thickness_x, pml_thickness_y, pml_thickness_z, grid_spacing, courant_factor
+	);
+}
+
+void FDTDCPU::initialzie_fields(
+	const std::vector<std::function<void(glm::ivec3, FDTD::ElectroMagneticProperty&)>>& member_initialization_lambdas,
+	glm::ivec3 grid_resolution,
+	glm::ivec2 pml_thickness_x,
+	glm::ivec2 pml_thickness_y,
+	glm::ivec2 pml_thickness_z,
+	glm::vec3 grid_spacing,
+	float courant_factor
+) {
+
+	if (member_initialization_lambdas.empty()) {
+		std::cout << "[FDTD Error] FDTDCPU::initialzie_fields() is called without initialization lambdas" << std::endl;
+		ASSERT(false);
+	}
+
+	if (glm::any(glm::lessThanEqual(grid_resolution, glm::ivec3(0))) || grid_resolution.z != 1) {
+		std::cout << "[FDTD Error] FDTDCPU::initialzie_fields() is called with invalid grid_resolution, only 2D grids are supported" << std::endl;
+		ASSERT(false);
+	}
+
+	if ((boundary_condition_x == FDTD::Absorbing && glm::any(glm::lessThanEqual(pml_thickness_x, glm::ivec2(0)))) ||
+		(boundary_condition_y == FDTD::Absorbing && glm::any(glm::lessThanEqual(pml_thickness_y, glm::ivec2(0))))
+	) {
+		std::cout << "[FDTD Error] FDTDCPU::initialzie_fields() is called with invalid pml_thickness" << std::endl;
+		ASSERT(false);
+	}
+
+	full_grid_resolution = grid_resolution;
+	symmetry_origin.x = FDTD::compute_symmetry_origin(symmetry_x, boundary_condition_x, symmetry_plane.x, grid_resolution.x);
+	symmetry_origin.y = FDTD::compute_symmetry_origin(symmetry_y, boundary_condition_y, symmetry_plane.y, grid_resolution.y);
+	grid_resolution = grid_resolution - symmetry_origin;
+
+	this->grid_resolution = grid_resolution;
+	this->pml_thickness_x = pml_thickness_x;
+	this->pml_thickness_y = pml_thickness_y;
+	this->pml_thickness_z = pml_thickness_z;
+
+	std::vector<float> full_node_spacing_x = FDTD::compute_node_spacing(graded_spacing_x, grid_spacing.x, full_grid_resolution.x);
+	std::vector<float> full_node_spacing_y = FDTD::compute_node_spacing(graded_spacing_y, grid_spacing.y, full_grid_resolution.y);
+
+	// the magnetic component staggered across a symmetry plane is mirrored onto the cell after it
+	if ((is_symmetric(0) && full_node_spacing_x[symmetry_origin.x - 1] != full_node_spacing_x[symmetry_origin.x]) ||
+		(is_symmetric(1) && full_node_spacing_y[symmetry_origin.y - 1] != full_node_spacing_y[symmetry_origin.y])
+	) {
+		std::cout << "[FDTD Error] FDTDCPU::initialzie_fields() is called with a graded mesh that does not mirror about the symmetry plane" << std::endl;
+		ASSERT(false);
+	}
+
+	bool complex_fields = boundary_condition_x == FDTD::BlochPeriodic || boundary_condition_y == FDTD::BlochPeriodic;
+	part_count = complex_fields ? 2 : 1;
+
+	node_positions_x = FDTD::compute_node_positions(full_node_spacing_x);
+	node_positions_y = FDTD::compute_node_positions(full_node_spacing_y);
+
+	bloch_phase.x = boundary_condition_x != FDTD::BlochPeriodic ? 0.0f :
+		graded_spacing_x.empty() ? bloch_wavevector.x * grid_resolution.x * grid_spacing.x : bloch_wavevector.x * std::accumulate(full_node_spacing_x.begin(), full_node_spacing_x.end(), 0.0);
+	bloch_phase.y = boundary_condition_y != FDTD::BlochPeriodic ? 0.0f :
+		graded_spacing_y.empty() ? bloch_wavevector.y * grid_resolution.y * grid_spacing.y : bloch_wavevector.y * std::accumulate(full_node_spacing_y.begin(), full_node_spacing_y.end(), 0.0);
+
+	// graded axes are as stable as their finest cell
+	grid_spacing.x = *std::min_element(full_node_spacing_x.begin(), full_node_spacing_x.end());
+	grid_spacing.y = *std::min_element(full_node_spacing_y.begin(), full_node_spacing_y.end());
+	this->grid_spacing = grid_spacing;
+	if (courant_factor == 0)
+		courant_factor = FDTD::compute_default_courant_factor(spatial_order);
+	dt = FDTD::compute_stable_timestep(grid_spacing, 2, courant_factor, spatial_order);
+
+	std::vector<float> full_dual_spacing_x = FDTD::compute_dual_spacing(full_node_spacing_x, is_periodic(0));
+	std::vector<float> full_dual_spacing_y = FDTD::compute_dual_spacing(full_node_spacing_y, is_periodic(1));
+
+	node_spacing_x.assign(full_node_spacing_x.begin() + symmetry_origin.x, full_node_spacing_x.end());
+	node_spacing_y.assign(full_node_spacing_y.begin() + symmetry_origin.y, full_node_spacing_y.end());
+	dual_spacing_x.assign(full_dual_spacing_x.begin() + symmetry_origin.x, full_dual_spacing_x.end());
+	dual_spacing_y.assign(full_dual_spacing_y.begin() + symmetry_origin.y, full_dual_spacing_y.end());
+
+	magnetic_coefficient_x.resize(grid_resolution.x);
+	electric_coefficient_x.resize(grid_resolution.x);
+	for (int32_t x = 0; x < grid_resolution.x; x++) {
+		magnetic_coefficient_x[x] = dt / (mu0 * node_spacing_x[x]);
+		electric_coefficient_x[x] = dt / (eps0 * dual_spacing_x[x]);
+	}
+
+	magnetic_coefficient_y.resize(grid_resolution.y);
+	electric_coefficient_y.resize(grid_resolution.y);
+	for (int32_t y = 0; y < grid_resolution.y; y++) {
+		magnetic_coefficient_y[y] = dt / (mu0 * node_spacing_y[y]);
+		electric_coefficient_y[y] = dt / (eps0 * dual_spacing_y[y]);
+	}
+
+	if (member_initialization_lambdas.size() > max_ensemble_lanes) {
+		std::cout << "[FDTD Error] FDTDCPU::initialzie_fields() is called with more than " << max_ensemble_lanes << " ensemble members" << std::endl;
+		ASSERT(false);
+	}
+
+	// members are padded to a power of two lanes, padding lanes carry no sources and their fields stay 0
+	ensemble_size = (int32_t)member_initialization_lambdas.size();
+	ensemble_lanes = 1;
+	while (ensemble_lanes < ensemble_size)
+		ensemble_lanes *= 2;
+
+	tick = 0;
+
+	size_t cell_count = (size_t)grid_resolution.x * grid_resolution.y * grid_resolution.z;
+	size_t field_count = cell_count * ensemble_lanes;
+
+	electric_field.assign(field_count, 0);
+	magnetic_field_x.assign(field_count, 0);
+	magnetic_field_y.assign(field_count, 0);
+
+	electric_field_imaginary.assign(complex_fields ? field_count : 0, 0);
+	magnetic_field_x_imaginary.assign(complex_fields ? field_count : 0, 0);
+	magnetic_field_y_imaginary.assign(complex_fields ? field_count : 0, 0);
+
+	properties.assign(field_count, FDTD::ElectroMagneticProperty());
+	electric_keep.assign(cell_count, 1);
+	electric_curl_mask.assign(cell_count, 0);
+	electric_damp.assign(cell_count, 1);
+	sources.clear();
+
+	for (int32_t z = 0; z < grid_resolution.z; z++) {
+		for (int32_t y = 0; y < grid_resolution.y; y++) {
+			for (int32_t x = 0; x < grid_resolution.x; x++) {
+
+				glm::ivec3 id(x, y, z);
+				size_t index = get_index(id);
+
+				for (int32_t member = 0; member < ensemble_size; member++) {
+
+					member_initialization_lambdas[member](id + symmetry_origin, properties[index * ensemble_lanes + member]);
+
+					if (properties[index * ensemble_lanes + member].voxel_type != properties[index * ensemble_lanes].voxel_type) {
+						std::cout << "[FDTD Error] FDTDCPU::initialzie_fields() is called with ensemble members of different geometry, only source parameters may differ" << std::endl;
+						ASSERT(false);
+					}
+				}
+
+				for (int32_t lane = ensemble_size; lane < ensemble_lanes; lane++)
+					properties[index * ensemble_lanes + lane] = properties[index * ensemble_lanes];
+
+				electric_damp[index] = pml_damp_coefficient(id);
+
+				setup_electric_cell(x, y);
+				add_sources(x, y);
+			}
+		}
+	}
+
+	// stencil masks need every property in place
+	size_t mask_count = spatial_order == 4 ? cell_count : 0;
+	magnetic_wide_x.assign(mask_count, 0);
+	magnetic_wide_y.assign(mask_count, 0);
+	electric_wide_x.assign(mask_count, 0);
+	electric_wide_y.assign(mask_count, 0);
+
+	if (spatial_order == 4)
+		for (int32_t y = 0; y < grid_resolution.y; y++)
+			for (int32_t x = 0; x < grid_resolution.x; x++)
+				setup_stencil_masks(x, y);
+
+	if (!autotune_profile_path.empty()) {
+
+		std::string cpu_model = FDTDAutotuner::get_cpu_model();
+		std::string grid_class = FDTDAutotuner::get_grid_class(*this);
+		FDTDAutotuner::Configuration configuration;
+
+		if (FDTDAutotuner::load_profile(autotune_profile_path, cpu_model, grid_class, configuration)) {
+			FDTDAutotuner::apply(*this, configuration);
+		}
+		else if (autotune_if_missing) {
+			configuration = FDTDAutotuner::tune(*this);
+			FDTDAutotuner::save_profile(autotune_profile_path, cpu_model, grid_class, configuration);
+			FDTDAutotuner::apply(*this, configuration);
+		}
+	}
+}
+
+void FDTDCPU::step()
+{
+	switch (kernel_variant) {
+	case Reference:
+		update_magnetic_reference();
+		update_electric_reference();
+		break;
+	case Vectorized:
+	case Tiled:
+		update_magnetic_vectorized();
+		update_electric_vectorized();
+		break;
+	}
+
+	tick++;
+}
+
+void FDTDCPU::iterate_time(int32_t tick_count)
+{
+	for (int32_t i = 0; i < tick_count; i++)
+		step();
+}
+
+FieldState FDTDCPU::get_field_state(int32_t member)
+{
+	if (member < 0 || member >= ensemble_size) {
+		std::cout << "[FDTD Error] FDTDCPU::get_field_state() is called with invalid member" << std::endl;
+		ASSERT(false);
+	}
+
+	FieldState state;
+	state.grid_resolution = grid_resolution;
+	state.tick = tick;
+
+	std::vector<float>* fields[] = {
+		&electric_field, &magnetic_field_x, &magnetic_field_y,
+		&electric_field_imaginary, &magnetic_field_x_imaginary, &magnetic_field_y_imaginary,
+	};
+	std::vector<float>* state_fields[] = {
+		&state.electric_field, &state.magnetic_field_x, &state.magnetic_field_y,
+		&state.electric_field_imaginary, &state.magnetic_field_x_imaginary, &state.magnetic_field_y_imaginary,
+	};
+
+	for (int32_t i = 0; i < 6; i++) {
+		size_t count = fields[i]->size() / ensemble_lanes;
+		state_fields[i]->resize(count);
+		for (size_t index = 0; index < count; index++)
+			(*state_fields[i])[index] = (*fields[i])[index * ensemble_lanes + member];
+	}
+
+	return state;
+}
+
+void FDTDCPU::load_field_state(const FieldState& state)
+{
+	if (state.grid_resolution != grid_resolution || state.is_complex() != is_complex()) {
+		std::cout << "[FDTD Error] FDTDCPU::load_field_state() is called with a state of another grid" << std::endl;
+		ASSERT(false);
+	}
+
+	std::vector<float>* fields[] = {
+		&electric_field, &magnetic_field_x, &magnetic_field_y,
+		&electric_field_imaginary, &magnetic_field_x_imaginary, &magnetic_field_y_imaginary,
+	};
+	const std::vector<float>* state_fields[] = {
+		&state.electric_field, &state.magnetic_field_x, &state.magnetic_field_y,
+		&state.electric_field_imaginary, &state.magnetic_field_x_imaginary, &state.magnetic_field_y_imaginary,
+	};
+
+	for (int32_t i = 0; i < 6; i++)
+		for (size_t index = 0; index < fields[i]->size(); index++)
+			(*fields[i])[index] = index % ensemble_lanes < (size_t)ensemble_size ? (*state_fields[i])[index / ensemble_lanes] : 0.0f;
+
+	tick = state.tick;
+}
+
+void FDTDCPU::patch_properties(const std::vector<FDTD::PropertyPatch>& patches)
+{
+	// one patch list would hand every member the same source parameters, members differ only in those
+	if (ensemble_size > 1) {
+		for (const FDTD::PropertyPatch& patch : patches) {
+			if (patch.property.voxel_type == FDTD::SourceSinosoidal || patch.property.voxel_type == FDTD::SourceImpulse || patch.property.voxel_type == FDTD::SourceSinosoidalSoft) {
+				std::cout << "[FDTD Error] FDTDCPU::patch_properties() is called with a source cell on an ensemble, patch every member with its own list" << std::endl;
+				ASSERT(false);
+			}
+		}
+	}
+
+	patch_properties(std::vector<std::vector<FDTD::PropertyPatch>>(ensemble_size, patches));
+}
+
+void FDTDCPU::patch_properties(const std::vector<std::vector<FDTD::PropertyPatch>>& member_patches)
+{
+	if (properties.empty()) {
+		std::cout << "[FDTD Error] FDTDCPU::patch_properties() is called before initialzie_fields()" << std::endl;
+		ASSERT(false);
+	}
+
+	if ((int32_t)member_patches.size() != ensemble_size) {
+		std::cout << "[FDTD Error] FDTDCPU::patch_properties() is called with " << member_patches.size() << " patch lists for " << ensemble_size << " ensemble members" << std::endl;
+		ASSERT(false);
+	}
+
+	std::vector<glm::ivec3> patched_cells;
+
+	for (int32_t member = 0; member < ensemble_size; member++) {
+		for (const FDTD::PropertyPatch& patch : member_patches[member]) {
+
+			if (glm::any(glm::lessThan(patch.id, glm::ivec3(0))) || glm::any(glm::greaterThanEqual(patch.id, full_grid_resolution))) {
+				std::cout << "[FDTD Error] FDTDCPU::patch_properties() is called with a cell outside the grid" << std::endl;
+				ASSERT(false);
+			}
+
+			// cells before a symmetry plane are mirror images, initialization_lambda never sees them either
+			glm::ivec3 id = patch.id - symmetry_origin;
+			if (glm::any(glm::lessThan(id, glm::ivec3(0))))
+				continue;
+
+			properties[get_index(id) * ensemble_lanes + member] = patch.property;
+			patched_cells.push_back(id);
+		}
+	}
+
+	// members patch the same cell when its geometry changes, other cells may only be patched by some of them
+	std::sort(patched_cells.begin(), patched_cells.end(), [&](glm::ivec3 a, glm::ivec3 b) { return get_index(a) < get_index(b); });
+	patched_cells.erase(std::unique(patched_cells.begin(), patched_cells.end()), patched_cells.end());
+
+	for (glm::ivec3 id : patched_cells) {
+
+		size_t index = get_index(id);
+
+		for (int32_t member = 1; member < ensemble_size; member++) {
+			if (properties[index * ensemble_lanes + member].voxel_type != properties[index * ensemble_lanes].voxel_type) {
+				std::cout << "[FDTD Error] FDTDCPU::patch_properties() is called with ensemble members of different geometry, only source parameters may differ" << std::endl;
+				ASSERT(false);
+			}
+		}
+
+		for (int32_t lane = ensemble_size; lane < ensemble_lanes; lane++)
+			properties[index * ensemble_lanes + lane] = properties[index * ensemble_lanes];
+
+		sources.erase(std::remove_if(sources.begin(), sources.end(), [&](const Source& source) { return source.index == index; }), sources.end());
+		setup_electric_cell(id.x, id.y);
+		add_sources(id.x, id.y);
+
+		// PEC and hard sources hold no field of their own, as if they had been there from the start
+		if (electric_keep[index] == 0)
+			for (int32_t part = 0; part < part_count; part++)
+				for (int32_t member = 0; member < ensemble_size; member++)
+					electric_part(part)[index * ensemble_lanes + member] = 0;
+	}
+
+	if (spatial_order != 4)
+		return;
+
+	// the widest taps reach two cells along each axis
+	for (glm::ivec3 id : patched_cells) {
+		for (int32_t y = id.y - 2; y <= id.y + 2; y++) {
+			for (int32_t x = id.x - 2; x <= id.x + 2; x++) {
+
+				int32_t wrapped_x = is_periodic(0) ? (x + grid_resolution.x) % grid_resolution.x : x;
+				int32_t wrapped_y = is_periodic(1) ? (y + grid_resolution.y) % grid_resolution.y : y;
+
+				if (wrapped_x < 0 || wrapped_y < 0 || wrapped_x >= grid_resolution.x || wrapped_y >= grid_resolution.y)
+					continue;
+
+				setup_stencil_masks(wrapped_x, wrapped_y);
+			}
+		}
+	}
+}
+
+int32_t FDTDCPU::get_total_ticks_elapsed()
+{
+	return tick;
+}
+
+glm::ivec3 FDTDCPU::get_grid_resolution()
+{
+	return grid_resolution;
+}
+
+glm::ivec3 FDTDCPU::get_full_grid_resolution()
+{
+	return full_grid_resolution;
+}
+
+glm::vec3 FDTDCPU::get_grid_spacing()
+{
+	return grid_spacing;
+}
+
+float FDTDCPU::get_timestep()
+{
+	return dt;
+}
+
+size_t FDTDCPU::get_index(glm::ivec3 id)
+{
+	return (size_t)id.z * grid_resolution.y * grid_resolution.x + (size_t)id.y * grid_resolution.x + id.x;
+}
+
+bool FDTDCPU::is_complex()
+{
+	return part_count == 2;
+}
+
+int32_t FDTDCPU::get_ensemble_size()
+{
+	return ensemble_size;
+}
+
+size_t FDTDCPU::get_field_index(glm::ivec3 id, int32_t member)
+{
+	return get_index(id) * ensemble_lanes + member;
+}
+
+bool FDTDCPU::is_periodic(int32_t axis)
+{
+	FDTD::BoundaryCondition boundary_condition = axis == 0 ? boundary_condition_x : boundary_condition_y;
+	return boundary_condition != FDTD::Absorbing;
+}
+
+bool FDTDCPU::is_symmetric(int32_t axis)
+{
+	FDTD::Symmetry symmetry = axis == 0 ? symmetry_x : symmetry_y;
+	return symmetry != FDTD::NoSymmetry;
+}
+
+bool FDTDCPU::is_on_odd_symmetry_plane(int32_t x, int32_t y)
+{
+	return
+		(symmetry_x == FDTD::OddSymmetry && x == 0) ||
+		(symmetry_y == FDTD::OddSymmetry && y == 0);
+}
+
+float FDTDCPU::get_electric_field(glm::ivec3 id, int32_t member)
+{
+	return load_unfolded(electric_field, ElectricZ, id, member);
+}
+
+float FDTDCPU::get_magnetic_field_x(glm::ivec3 id, int32_t member)
+{
+	return load_unfolded(magnetic_field_x, MagneticX, id, member);
+}
+
+float FDTDCPU::get_magnetic_field_y(glm::ivec3 id, int32_t member)
+{
+	return load_unfolded(magnetic_field_y, MagneticY, id, member);
+}
+
+std::vector<float> FDTDCPU::get_unfolded_electric_field(int32_t member)
+{
+	std::vector<float> field((size_t)full_grid_resolution.x * full_grid_resolution.y * full_grid_resolution.z);
+
+	for (int32_t y = 0; y < full_grid_resolution.y; y++)
+		for (int32_t x = 0; x < full_grid_resolution.x; x++)
+			field[(size_t)y * full_grid_resolution.x + x] = get_electric_field(glm::ivec3(x, y, 0), member);
+
+	return field;
+}
+
+std::vector<float> FDTDCPU::get_node_positions(int32_t axis)
+{
+	return axis == 0 ? node_positions_x : node_positions_y;
+}
+
+// cells before a symmetry plane are the mirror image of simulated ones. the component staggered along the
+// axis sits half a cell off the plane and has the opposite parity of Ez, cells with no mirror image read as 0
+float FDTDCPU::load_unfolded(const std::vector<float>& field, FieldComponent component, glm::ivec3 id, int32_t member)
+{
+	size_t index;
+	float sign;
+
+	if (!locate_unfolded(component, id, member, index, sign))
+		return 0;
+
+	return sign * field[index];
+}
+
+bool FDTDCPU::locate_unfolded(FieldComponent component, glm::ivec3 id, int32_t member, size_t& index, float& sign)
+{
+	if (member < 0 || member >= ensemble_size) {
+		std::cout << "[FDTD Error] FDTDCPU is called with invalid ensemble member" << std::endl;
+		ASSERT(false);
+	}
+
+	sign = 1;
+
+	for (int32_t axis = 0; axis < 2; axis++) {
+
+		id[axis] -= symmetry_origin[axis];
+
+		if (id[axis] >= 0)
+			continue;
+
+		bool staggered = (axis == 0 && component == MagneticY) || (axis == 1 && component == MagneticX);
+		bool odd = (axis == 0 ? symmetry_x : symmetry_y) == FDTD::OddSymmetry;
+
+		id[axis] = -id[axis] - (staggered ? 1 : 0);
+		sign *= odd != staggered ? -1.0f : 1.0f;
+	}
+
+	if (glm::any(glm::lessThan(id, glm::ivec3(0))) || glm::any(glm::greaterThanEqual(id, grid_resolution)))
+		return false;
+
+	index = get_field_index(id, member);
+	return true;
+}
+
+// absorbing axes leave the last magnetic and the outermost electric cells to the damping like the compute shaders,
+// periodic axes update every cell and reach across the edge
+
+bool FDTDCPU::is_in_magnetic_update_domain(int32_t x, int32_t y)
+{
+	return
+		x < grid_resolution.x - (is_periodic(0) ? 0 : 1) &&
+		y < grid_resolution.y - (is_periodic(1) ? 0 : 1);
+}
+
+bool FDTDCPU::is_in_electric_update_domain(int32_t x, int32_t y)
+{
+	int32_t margin_x = is_periodic(0) ? 0 : 1;
+	int32_t margin_y = is_periodic(1) ? 0 : 1;
+
+	// symmetric axes begin on the symmetry plane, which is updated like any other cell
+	return
+		x >= (is_symmetric(0) ? 0 : margin_x) && x < grid_resolution.x - margin_x &&
+		y >= (is_symmetric(1) ? 0 : margin_y) && y < grid_resolution.y - margin_y;
+}
+
+// coordinates past the edge of a periodic axis wrap around and pick up the bloch phase of that axis.
+// coordinates before a symmetry plane read the mirror image the same way load_unfolded does
+float FDTDCPU::load_wrapped(const std::vector<float>& real, const std::vector<float>& imaginary, FieldComponent component, int32_t x, int32_t y, int32_t part, int32_t member)
+{
+	float phase = 0;
+	float sign = 1;
+
+	bool staggered_x = component == MagneticY;
+	bool staggered_y = component == MagneticX;
+
+	if (x < 0 && is_symmetric(0))	{ x = -x - (staggered_x ? 1 : 0); sign *= (symmetry_x == FDTD::OddSymmetry) != staggered_x ? -1.0f : 1.0f; }
+	if (y < 0 && is_symmetric(1))	{ y = -y - (staggered_y ? 1 : 0); sign *= (symmetry_y == FDTD::OddSymmetry) != staggered_y ? -1.0f : 1.0f; }
+
+	if (x < 0)						{ x += grid_resolution.x; phase += bloch_phase.x; }
+	if (x >= grid_resolution.x)		{ x -= grid_resolution.x; phase -= bloch_phase.x; }
+	if (y < 0)						{ y += grid_resolution.y; phase += bloch_phase.y; }
+	if (y >= grid_resolution.y)		{ y -= grid_resolution.y; phase -= bloch_phase.y; }
+
+	size_t index = get_index(glm::ivec3(x, y, 0)) * ensemble_lanes + member;
+
+	if (phase == 0)
+		return sign * (part == 0 ? real[index] : imaginary[index]);
+
+	float cos_phase = std::cos(phase);
+	float sin_phase = std::sin(phase);
+
+	return sign * (part == 0 ?
+		real[index] * cos_phase - imaginary[index] * sin_phase :
+		real[index] * sin_phase + imaginary[index] * cos_phase);
+}
+
+std::vector<float>& FDTDCPU::electric_part(int32_t part)
+{
+	return part == 0 ? electric_field : electric_field_imaginary;
+}
+
+std::vector<float>& FDTDCPU::magnetic_x_part(int32_t part)
+{
+	return part == 0 ? magnetic_field_x : magnetic_field_x_imaginary;
+}
+
+std::vector<float>& FDTDCPU::magnetic_y_part(int32_t part)
+{
+	return part == 0 ? magnetic_field_y : magnetic_field_y_imaginary;
+}
+
+float FDTDCPU::pml_damp_coefficient(glm::ivec3 coord)
+{
+	float damp_coefficient = 1;
+
+	int32_t distance_to_edge_px = coord.x;
+	int32_t distance_to_edge_nx = grid_resolution.x - 1 - coord.x;
+
+	int32_t distance_to_edge_py = coord.y;
+	int32_t distance_to_edge_ny = grid_resolution.y - 1 - coord.y;
+
+	float ref = -0.02f;
+
+	// the near side of a symmetric axis is the symmetry plane, not a boundary
+	if (!is_periodic(0)) {
+		if (!is_symmetric(0))
+			damp_coefficient *= (distance_to_edge_px <= pml_thickness_x.x) ? std::exp(ref * (pml_thickness_x.x - distance_to_edge_px)) : 1.0f;
+		damp_coefficient *= (distance_to_edge_nx <= pml_thickness_x.y) ? std::exp(ref * (pml_thickness_x.y - distance_to_edge_nx)) : 1.0f;
+	}
+
+	if (!is_periodic(1)) {
+		if (!is_symmetric(1))
+			damp_coefficient *= (distance_to_edge_py <= pml_thickness_y.x) ? std::exp(ref * (pml_thickness_y.x - distance_to_edge_py)) : 1.0f;
+		damp_coefficient *= (distance_to_edge_ny <= pml_thickness_y.y) ? std::exp(ref * (pml_thickness_y.y - distance_to_edge_ny)) : 1.0f;
+	}
+
+	return damp_coefficient;
+}
+
+// keep and curl mask of a cell from the voxel type its ensemble members share
+void FDTDCPU::setup_electric_cell(int32_t x, int32_t y)
+{
+	size_t index = get_index(glm::ivec3(x, y, 0));
+	const FDTD::ElectroMagneticProperty& property = properties[index * ensemble_lanes];
+
+	electric_keep[index] = 1;
+	electric_curl_mask[index] = 0;
+
+	if (!is_in_electric_update_domain(x, y))
+		return;
+
+	if (is_on_odd_symmetry_plane(x, y)) {
+		electric_keep[index] = 0;
+		return;
+	}
+
+	switch (property.voxel_type) {
+	case FDTD::Normal:
+		electric_curl_mask[index] = 1;
+		break;
+	case FDTD::PEC:
+		electric_keep[index] = 0;
+		break;
+	case FDTD::SourceSinosoidal:
+		electric_keep[index] = 0;
+		break;
+	case FDTD::SourceImpulse:
+	case FDTD::SourceSinosoidalSoft:
+		electric_curl_mask[index] = 1;
+		break;
+	}
+}
+
+// sinusoidal and impulse cells are appended to the sources with the parameters of every ensemble member
+void FDTDCPU::add_sources(int32_t x, int32_t y)
+{
+	size_t index = get_index(glm::ivec3(x, y, 0));
+	FDTD::VoxelType voxel_type = properties[index * ensemble_lanes].voxel_type;
+
+	if (!is_in_electric_update_domain(x, y) || is_on_odd_symmetry_plane(x, y))
+		return;
+
+	if (voxel_type != FDTD::SourceSinosoidal && voxel_type != FDTD::SourceImpulse && voxel_type != FDTD::SourceSinosoidalSoft)
+		return;
+
+	for (int32_t member = 0; member < ensemble_size; member++) {
+		const FDTD::ElectroMagneticProperty& property = properties[index * ensemble_lanes + member];
+		sources.push_back({ index, member, property.voxel_type, property.source_frequency, property.source_amplitude, property.source_phase });
+	}
+}
+
+// 1 where the fourth order taps are usable and 0 where the update falls back, needs the properties around the cell
+void FDTDCPU::setup_stencil_masks(int32_t x, int32_t y)
+{
+	size_t index = get_index(glm::ivec3(x, y, 0));
+
+	magnetic_wide_x[index] = is_wide_stencil(x, y, glm::ivec2(1, 0), -1, 2) ? 1.0f : 0.0f;
+	magnetic_wide_y[index] = is_wide_stencil(x, y, glm::ivec2(0, 1), -1, 2) ? 1.0f : 0.0f;
+	electric_wide_x[index] = is_wide_stencil(x, y, glm::ivec2(1, 0), -2, 2) ? 1.0f : 0.0f;
+	electric_wide_y[index] = is_wide_stencil(x, y, glm::ivec2(0, 1), -2, 2) ? 1.0f : 0.0f;
+}
+
+// cells the fourth order stencil may reach, anything else makes it fall back to the Yee stencil.
+// cells before a symmetry plane are the exact mirror image of simulated ones and so is the zero Ez on an odd plane
+bool FDTDCPU::is_regular_cell(int32_t x, int32_t y)
+{
+	if (is_periodic(0)) x = (x + grid_resolution.x) % grid_resolution.x;
+	if (is_periodic(1)) y = (y + grid_resolution.y) % grid_resolution.y;
+	if (is_symmetric(0) && x < 0) x = -x;
+	if (is_symmetric(1) && y < 0) y = -y;
+
+	if (x < 0 || y < 0 || x >= grid_resolution.x || y >= grid_resolution.y)
+		return false;
+
+	FDTD::VoxelType voxel_type = properties[get_index(glm::ivec3(x, y, 0)) * ensemble_lanes].voxel_type;
+	return voxel_type != FDTD::PEC && voxel_type != FDTD::SourceSinosoidal && !is_in_absorbing_layer(x, y);
+}
+
+// the near side of a symmetric axis is the symmetry plane, not a boundary
+bool FDTDCPU::is_in_absorbing_layer(int32_t x, int32_t y)
+{
+	return
+		(!is_periodic(0) && ((!is_symmetric(0) && x <= pml_thickness_x.x) || grid_resolution.x - 1 - x <= pml_thickness_x.y)) ||
+		(!is_periodic(1) && ((!is_symmetric(1) && y <= pml_thickness_y.x) || grid_resolution.y - 1 - y <= pml_thickness_y.y));
+}
+
+// all cells from (x, y) + first * direction to (x, y) + last * direction are regular and, on a graded mesh,
+// evenly spaced since the fourth order coefficients assume a uniform mesh under the taps. the spacings
+// between those nodes are node_spacing[along + first] to node_spacing[along + last - 1]
+bool FDTDCPU::is_wide_stencil(int32_t x, int32_t y, glm::ivec2 direction, int32_t first, int32_t last)
+{
+	if (spatial_order != 4)
+		return false;
+
+	for (int32_t i = first; i <= last; i++)
+		if (!is_regular_cell(x + i * direction.x, y + i * direction.y))
+			return false;
+
+	const std::vector<float>& node_spacing = direction.x != 0 ? node_spacing_x : node_spacing_y;
+	int32_t resolution = (int32_t)node_spacing.size();
+	int32_t along = direction.x != 0 ? x : y;
+	bool symmetric = is_symmetric(direction.x != 0 ? 0 : 1);
+
+	// the spacing from node -k to -k + 1 before a symmetry plane is the one from node k - 1 to k
+	auto spacing_index = [&](int32_t i) {
+		return symmetric && i < 0 ? -i - 1 : (i + resolution) % resolution;
+	};
+
+	for (int32_t i = first + 1; i < last; i++)
+		if (node_spacing[spacing_index(along + i)] != node_spacing[spacing_index(along + first)])
+			return false;
+
+	return true;
+}
+
+// straight port of magnetic_update.comp / electric_update.comp, kept as the ground truth for the other variants
+
+void FDTDCPU::update_magnetic_reference()
+{
+	for (int32_t part = 0; part < part_count; part++) {
+		for (int32_t member = 0; member < ensemble_size; member++) {
+
+			std::vector<float>& magnetic_x = magnetic_x_part(part);
+			std::vector<float>& magnetic_y = magnetic_y_part(part);
+
+			for (int32_t y = 0; y < grid_resolution.y; y++) {
+				for (int32_t x = 0; x < grid_resolution.x; x++) {
+
+					if (!is_in_magnetic_update_domain(x, y))
+						continue;
+
+					size_t index = get_index(glm::ivec3(x, y, 0)) * ensemble_lanes + member;
+
+					float electric_value00 = load_wrapped(electric_field, electric_field_imaginary, ElectricZ, x, y, part, member);
+					float electric_value01 = load_wrapped(electric_field, electric_field_imaginary, ElectricZ, x + 1, y, part, member);
+					float electric_value10 = load_wrapped(electric_field, electric_field_imaginary, ElectricZ, x, y + 1, part, member);
+
+					// FDTD(2,4): (9/8 * (f[+1/2] - f[-1/2]) - 1/24 * (f[+3/2] - f[-3/2])) / d
+					float inner_x = 1, outer_x = 0;
+					float inner_y = 1, outer_y = 0;
+					float electric_value_xp2 = 0, electric_value_xm1 = 0;
+					float electric_value_yp2 = 0, electric_value_ym1 = 0;
+
+					if (is_wide_stencil(x, y, glm::ivec2(1, 0), -1, 2)) {
+						inner_x = 9.0f / 8.0f;
+						outer_x = 1.0f / 24.0f;
+						electric_value_xp2 = load_wrapped(electric_field, electric_field_imaginary, ElectricZ, x + 2, y, part, member);
+						electric_value_xm1 = load_wrapped(electric_field, electric_field_imaginary, ElectricZ, x - 1, y, part, member);
+					}
+
+					if (is_wide_stencil(x, y, glm::ivec2(0, 1), -1, 2)) {
+						inner_y = 9.0f / 8.0f;
+						outer_y = 1.0f / 24.0f;
+						electric_value_yp2 = load_wrapped(electric_field, electric_field_imaginary, ElectricZ, x, y + 2, part, member);
+						electric_value_ym1 = load_wrapped(electric_field, electric_field_imaginary, ElectricZ, x, y - 1, part, member);
+					}
+
+					magnetic_x[index] -= (dt / mu0) *
+						(inner_y * (electric_value10 - electric_value00) - outer_y * (electric_value_yp2 - electric_value_ym1)) / node_spacing_y[y];
+
+					magnetic_y[index] += (dt / mu0) *
+						(inner_x * (electric_value01 - electric_value00) - outer_x * (electric_value_xp2 - electric_value_xm1)) / node_spacing_x[x];
+				}
+			}
+		}
+	}
+}
+
+void FDTDCPU::update_electric_reference()
+{
+	for (int32_t part = 0; part < part_count; part++) {
+		for (int32_t member = 0; member < ensemble_size; member++) {
+
+			std::vector<float>& electric = electric_part(part);
+
+			for (int32_t y = 0; y < grid_resolution.y; y++) {
+				for (int32_t x = 0; x < grid_resolution.x; x++) {
+
+					glm::ivec3 id(x, y, 0);
+					size_t index = get_index(id) * ensemble_lanes + member;
+
+					float electric_value = electric[index];
+
+					if (is_in_electric_update_domain(x, y)) {
+
+						FDTD::ElectroMagneticProperty& property = properties[index];
+
+						if (property.voxel_type == FDTD::Normal || property.voxel_type == FDTD::SourceSinosoidalSoft || property.voxel_type == FDTD::SourceImpulse) {
+							float magnetic_x00 = load_wrapped(magnetic_field_x, magnetic_field_x_imaginary, MagneticX, x, y, part, member);
+							float magnetic_x10 = load_wrapped(magnetic_field_x, magnetic_field_x_imaginary, MagneticX, x, y - 1, part, member);
+							float magnetic_y00 = load_wrapped(magnetic_field_y, magnetic_field_y_imaginary, MagneticY, x, y, part, member);
+							float magnetic_y01 = load_wrapped(magnetic_field_y, magnetic_field_y_imaginary, MagneticY, x - 1, y, part, member);
+
+							float inner_x = 1, outer_x = 0;
+							float inner_y = 1, outer_y = 0;
+							float magnetic_y_xp1 = 0, magnetic_y_xm2 = 0;
+							float magnetic_x_yp1 = 0, magnetic_x_ym2 = 0;
+
+							if (is_wide_stencil(x, y, glm::ivec2(1, 0), -2, 2)) {
+								inner_x = 9.0f / 8.0f;
+								outer_x = 1.0f / 24.0f;
+								magnetic_y_xp1 = load_wrapped(magnetic_field_y, magnetic_field_y_imaginary, MagneticY, x + 1, y, part, member);
+								magnetic_y_xm2 = load_wrapped(magnetic_field_y, magnetic_field_y_imaginary, MagneticY, x - 2, y, part, member);
+							}
+
+							if (is_wide_stencil(x, y, glm::ivec2(0, 1), -2, 2)) {
+								inner_y = 9.0f / 8.0f;
+								outer_y = 1.0f / 24.0f;
+								magnetic_x_yp1 = load_wrapped(magnetic_field_x, magnetic_field_x_imaginary, MagneticX, x, y + 1, part, member);
+								magnetic_x_ym2 = load_wrapped(magnetic_field_x, magnetic_field_x_imaginary, MagneticX, x, y - 2, part, member);
+							}
+
+							electric_value += (dt / eps0) *
+								((inner_x * (magnetic_y00 - magnetic_y01) - outer_x * (magnetic_y_xp1 - magnetic_y_xm2)) / dual_spacing_x[x] -
+								(inner_y * (magnetic_x00 - magnetic_x10) - outer_y * (magnetic_x_yp1 - magnetic_x_ym2)) / dual_spacing_y[y]);
+
+							if (property.voxel_type == FDTD::SourceSinosoidalSoft)
+								electric_value += sinusoidal_source_value(property.source_frequency, property.source_amplitude, property.source_phase, tick, dt, part);
+							else if (property.voxel_type == FDTD::SourceImpulse)
+								electric_value += impulse_source_value(tick, part);
+						}
+						else if (property.voxel_type == FDTD::PEC) {
+							electric_value = 0;
+						}
+						else if (property.voxel_type == FDTD::SourceSinosoidal) {
+							electric_value = sinusoidal_source_value(property.source_frequency, property.source_amplitude, property.source_phase, tick, dt, part);
+						}
+
+						if (is_on_odd_symmetry_plane(x, y))
+							electric_value = 0;
+					}
+
+					electric_value *= pml_damp_coefficient(id);
+					electric[index] = electric_value;
+				}
+			}
+		}
+	}
+}
+
+// branch free sweeps over precomputed coefficients for the interior, the cells around it go through the
+// per cell updates (wrapping on periodic axes, damping only on absorbing ones) and sources are applied
+// afterwards from a sparse list. the fourth order sweeps blend in the wide taps with the precomputed stencil masks
+// and keep one more cell away from the edges so every tap stays inside the grid.
+// the tiled variant runs the same interior sweeps tile by tile on the worker pool, every cell sees the same
+// arithmetic so both variants agree bit for bit
+
+void FDTDCPU::update_magnetic_vectorized()
+{
+	const int32_t margin = spatial_order == 4 ? 1 : 0;
+	const glm::ivec2 begin(margin, margin);
+	const glm::ivec2 end(grid_resolution.x - 1 - margin, grid_resolution.y - 1 - margin);
+
+	if (kernel_variant == Tiled)
+		for_each_tile(begin, end, [&](glm::ivec2 tile_begin, glm::ivec2 tile_end) { sweep_magnetic(tile_begin, tile_end); });
+	else
+		sweep_magnetic(begin, end);
+
+	for (int32_t y = 0; y < grid_resolution.y; y++) {
+		for (int32_t x = 0; x < grid_resolution.x; x++) {
+
+			if (y >= begin.y && y < end.y && x >= begin.x && x < end.x) {
+				x = end.x - 1;
+				continue;
+			}
+
+			if (is_in_magnetic_update_domain(x, y))
+				update_magnetic_cell(x, y);
+		}
+	}
+}
+
+void FDTDCPU::update_electric_vectorized()
+{
+	const int32_t margin = spatial_order == 4 ? 1 : 0;
+	const glm::ivec2 begin(1 + margin, 1 + margin);
+	const glm::ivec2 end(grid_resolution.x - 1 - margin, grid_resolution.y - 1 - margin);
+
+	if (kernel_variant == Tiled)
+		for_each_tile(begin, end, [&](glm::ivec2 tile_begin, glm::ivec2 tile_end) { sweep_electric(tile_begin, tile_end); });
+	else
+		sweep_electric(begin, end);
+
+	for (int32_t y = 0; y < grid_resolution.y; y++) {
+		for (int32_t x = 0; x < grid_resolution.x; x++) {
+
+			if (y >= begin.y && y < end.y && x >= begin.x && x < end.x) {
+				x = end.x - 1;
+				continue;
+			}
+
+			update_electric_cell(x, y);
+		}
+	}
+
+	apply_sources();
+}
+
+// the lanes of a cell sit next to each other and are updated together as one LaneVector, so the coefficients
+// and stencil masks of the cell are loaded once for all members. with a single lane these are plain row sweeps
+
+template<int32_t lane_count>
+void FDTDCPU::sweep_magnetic_lanes(glm::ivec2 begin, glm::ivec2 end)
+{
+	typedef LaneVector<lane_count> Lanes;
+
+	const int32_t width = grid_resolution.x;
+	const size_t stride_y = (size_t)width * lane_count;
+	const float* __restrict coefficient_x = magnetic_coefficient_x.data();
+
+	for (int32_t part = 0; part < part_count; part++) {
+		for (int32_t y = begin.y; y < end.y; y++) {
+
+			size_t row = (size_t)y * width;
+			const float coefficient_y = magnetic_coefficient_y[y];
+
+			const float* __restrict electric = electric_part(part).data() + row * lane_count;
+			float* __restrict magnetic_x = magnetic_x_part(part).data() + row * lane_count;
+			float* __restrict magnetic_y = magnetic_y_part(part).data() + row * lane_count;
+
+			if (spatial_order == 4) {
+
+				const float* __restrict wide_x = magnetic_wide_x.data() + row;
+				const float* __restrict wide_y = magnetic_wide_y.data() + row;
+
+				for (int32_t x = begin.x; x < end.x; x++) {
+					float inner_x = 1.0f + wide_x[x] * (1.0f / 8.0f);
+					float outer_x = wide_x[x] * (1.0f / 24.0f);
+					float inner_y = 1.0f + wide_y[x] * (1.0f / 8.0f);
+					float outer_y = wide_y[x] * (1.0f / 24.0f);
+					float cell_coefficient_x = coefficient_x[x];
+
+					const float* cell = electric + (size_t)x * lane_count;
+					Lanes electric_00 = lanes_at<lane_count>(cell);
+					Lanes electric_x_delta = lanes_at<lane_count>(cell + lane_count) - electric_00;
+					Lanes electric_y_delta = lanes_at<lane_count>(cell + stride_y) - electric_00;
+					Lanes electric_x_outer = lanes_at<lane_count>(cell + 2 * lane_count) - lanes_at<lane_count>(cell - lane_count);
+					Lanes electric_y_outer = lanes_at<lane_count>(cell + 2 * stride_y) - lanes_at<lane_count>(cell - stride_y);
+
+					Lanes updated_x = lanes_at<lane_count>(magnetic_x + (size_t)x * lane_count) -
+						coefficient_y * (inner_y * electric_y_delta - outer_y * electric_y_outer);
+					Lanes updated_y = lanes_at<lane_count>(magnetic_y + (size_t)x * lane_count) +
+						cell_coefficient_x * (inner_x * electric_x_delta - outer_x * electric_x_outer);
+
+					lanes_at<lane_count>(magnetic_x + (size_t)x * lane_count) = updated_x;
+					lanes_at<lane_count>(magnetic_y + (size_t)x * lane_count) = updated_y;
+				}
+			}
+			else {
+				for (int32_t x = begin.x; x < end.x; x++) {
+					float cell_coefficient_x = coefficient_x[x];
+
+					const float* cell = electric + (size_t)x * lane_count;
+					Lanes electric_00 = lanes_at<lane_count>(cell);
+
+					Lanes updated_x = lanes_at<lane_count>(magnetic_x + (size_t)x * lane_count) -
+						coefficient_y * (lanes_at<lane_count>(cell + stride_y) - electric_00);
+					Lanes updated_y = lanes_at<lane_count>(magnetic_y + (size_t)x * lane_count) +
+						cell_coefficient_x * (lanes_at<lane_count>(cell + lane_count) - electric_00);
+
+					lanes_at<lane_count>(magnetic_x + (size_t)x * lane_count) = updated_x;
+					lanes_at<lane_count>(magnetic_y + (size_t)x * lane_count) = updated_y;
+				}
+			}
+		}
+	}
+}
+
+template<int32_t lane_count>
+void FDTDCPU::sweep_electric_lanes(glm::ivec2 begin, glm::ivec2 end)
+{
+	typedef LaneVector<lane_count> Lanes;
+
+	const int32_t width = grid_resolution.x;
+	const size_t stride_y = (size_t)width * lane_count;
+	const float* __restrict coefficient_x = electric_coefficient_x.data();
+
+	for (int32_t part = 0; part < part_count; part++) {
+		for (int32_t y = begin.y; y < end.y; y++) {
+
+			size_t row = (size_t)y * width;
+			const float coefficient_y = electric_coefficient_y[y];
+
+			float* __restrict electric = electric_part(part).data() + row * lane_count;
+			const float* __restrict magnetic_x = magnetic_x_part(part).data() + row * lane_count;
+			const float* __restrict magnetic_y = magnetic_y_part(part).data() + row * lane_count;
+			const float* __restrict keep = electric_keep.data() + row;
+			const float* __restrict curl_mask = electric_curl_mask.data() + row;
+			const float* __restrict damp = electric_damp.data() + row;
+
+			if (spatial_order == 4) {
+
+				const float* __restrict wide_x = electric_wide_x.data() + row;
+				const float* __restrict wide_y = electric_wide_y.data() + row;
+
+				for (int32_t x = begin.x; x < end.x; x++) {
+					float inner_x = 1.0f + wide_x[x] * (1.0f / 8.0f);
+					float outer_x = wide_x[x] * (1.0f / 24.0f);
+					float inner_y = 1.0f + wide_y[x] * (1.0f / 8.0f);
+					float outer_y = wide_y[x] * (1.0f / 24.0f);
+					float cell_keep = keep[x], cell_curl_mask = curl_mask[x], cell_damp = damp[x];
+					float cell_coefficient_x = coefficient_x[x];
+
+					const float* cell_x = magnetic_x + (size_t)x * lane_count;
+					const float* cell_y = magnetic_y + (size_t)x * lane_count;
+					Lanes magnetic_y_delta = lanes_at<lane_count>(cell_y) - lanes_at<lane_count>(cell_y - lane_count);
+					Lanes magnetic_x_delta = lanes_at<lane_count>(cell_x) - lanes_at<lane_count>(cell_x - stride_y);
+					Lanes magnetic_y_outer = lanes_at<lane_count>(cell_y + lane_count) - lanes_at<lane_count>(cell_y - 2 * lane_count);
+					Lanes magnetic_x_outer = lanes_at<lane_count>(cell_x + stride_y) - lanes_at<lane_count>(cell_x - 2 * stride_y);
+
+					Lanes curl =
+						cell_coefficient_x * (inner_x * magnetic_y_delta - outer_x * magnetic_y_outer) -
+						coefficient_y * (inner_y * magnetic_x_delta - outer_y * magnetic_x_outer);
+
+					Lanes updated = cell_damp * (cell_keep * lanes_at<lane_count>(electric + (size_t)x * lane_count) + cell_curl_mask * curl);
+					lanes_at<lane_count>(electric + (size_t)x * lane_count) = updated;
+				}
+			}
+			else {
+				for (int32_t x = begin.x; x < end.x; x++) {
+					float cell_keep = keep[x], cell_curl_mask = curl_mask[x], cell_damp = damp[x];
+					float cell_coefficient_x = coefficient_x[x];
+
+					const float* cell_x = magnetic_x + (size_t)x * lane_count;
+					const float* cell_y = magnetic_y + (size_t)x * lane_count;
+
+					Lanes curl =
+						cell_coefficient_x * (lanes_at<lane_count>(cell_y) - lanes_at<lane_count>(cell_y - lane_count)) -
+						coefficient_y * (lanes_at<lane_count>(cell_x) - lanes_at<lane_count>(cell_x - stride_y));
+
+					Lanes updated = cell_damp * (cell_keep * lanes_at<lane_count>(electric + (size_t)x * lane_count) + cell_curl_mask * curl);
+					lanes_at<lane_count>(electric + (size_t)x * lane_count) = updated;
+				}
+			}
+		}
+	}
+}
+
+void FDTDCPU::sweep_magnetic(glm::ivec2 begin, glm::ivec2 end)
+{
+	switch (ensemble_lanes) {
+	case 1:		sweep_magnetic_lanes<1>(begin, end);	break;
+	case 2:		sweep_magnetic_lanes<2>(begin, end);	break;
+	case 4:		sweep_magnetic_lanes<4>(begin, end);	break;
+	case 8:		sweep_magnetic_lanes<8>(begin, end);	break;
+	case 16:	sweep_magnetic_lanes<16>(begin, end);	break;
+	}
+}
+
+void FDTDCPU::sweep_electric(glm::ivec2 begin, glm::ivec2 end)
+{
+	switch (ensemble_lanes) {
+	case 1:		sweep_electric_lanes<1>(begin, end);	break;
+	case 2:		sweep_electric_lanes<2>(begin, end);	break;
+	case 4:		sweep_electric_lanes<4>(begin, end);	break;
+	case 8:		sweep_electric_lanes<8>(begin, end);	break;
+	case 16:	sweep_electric_lanes<16>(begin, end);	break;
+	}
+}
+
+// splits [begin, end) into tile_size tiles (0 spans the whole axis) and hands them to the worker pool
+void FDTDCPU::for_each_tile(glm::ivec2 begin, glm::ivec2 end, const std::function<void(glm::ivec2, glm::ivec2)>& sweep)
+{
+	if (end.x <= begin.x || end.y <= begin.y)
+		return;
+
+	glm::ivec2 extent = end - begin;
+	glm::ivec2 tile(
+		tile_size.x > 0 ? std::min(tile_size.x, extent.x) : extent.x,
+		tile_size.y > 0 ? std::min(tile_size.y, extent.y) : extent.y
+	);
+	glm::ivec2 tile_count((extent.x + tile.x - 1) / tile.x, (extent.y + tile.y - 1) / tile.y);
+
+	int32_t threads = thread_count > 0 ? thread_count : WorkerPool::get_hardware_thread_count();
+	if (worker_pool == nullptr || worker_pool->get_thread_count() != threads)
+		worker_pool = std::make_shared<WorkerPool>(threads);
+
+	worker_pool->run(tile_count.x * tile_count.y, [&](int32_t task) {
+		glm::ivec2 tile_begin = begin + glm::ivec2(task % tile_count.x, task / tile_count.x) * tile;
+		glm::ivec2 tile_end(std::min(tile_begin.x + tile.x, end.x), std::min(tile_begin.y + tile.y, end.y));
+		sweep(tile_begin, tile_end);
+		});
+}
+
+void FDTDCPU::update_magnetic_cell(int32_t x, int32_t y)
+{
+	size_t index = get_index(glm::ivec3(x, y, 0));
+
+	float wide_x = spatial_order == 4 ? magnetic_wide_x[index] : 0.0f;
+	float wide_y = spatial_order == 4 ? magnetic_wide_y[index] : 0.0f;
+
+	for (int32_t part = 0; part < part_count; part++) {
+		for (int32_t member = 0; member < ensemble_size; member++) {
+
+			float electric_value00 = load_wrapped(electric_field, electric_field_imaginary, ElectricZ, x, y, part, member);
+			float electric_value01 = load_wrapped(electric_field, electric_field_imaginary, ElectricZ, x + 1, y, part, member);
+			float electric_value10 = load_wrapped(electric_field, electric_field_imaginary, ElectricZ, x, y + 1, part, member);
+
+			float electric_value_xp2 = 0, electric_value_xm1 = 0;
+			float electric_value_yp2 = 0, electric_value_ym1 = 0;
+
+			if (wide_x != 0) {
+				electric_value_xp2 = load_wrapped(electric_field, electric_field_imaginary, ElectricZ, x + 2, y, part, member);
+				electric_value_xm1 = load_wrapped(electric_field, electric_field_imaginary, ElectricZ, x - 1, y, part, member);
+			}
+
+			if (wide_y != 0) {
+				electric_value_yp2 = load_wrapped(electric_field, electric_field_imaginary, ElectricZ, x, y + 2, part, member);
+				electric_value_ym1 = load_wrapped(electric_field, electric_field_imaginary, ElectricZ, x, y - 1, part, member);
+			}
+
+			magnetic_x_part(part)[index * ensemble_lanes + member] -= dt / (mu0 * node_spacing_y[y]) *
+				((1.0f + wide_y * (1.0f / 8.0f)) * (electric_value10 - electric_value00) - wide_y * (1.0f / 24.0f) * (electric_value_yp2 - electric_value_ym1));
+			magnetic_y_part(part)[index * ensemble_lanes + member] += dt / (mu0 * node_spacing_x[x]) *
+				((1.0f + wide_x * (1.0f / 8.0f)) * (electric_value01 - electric_value00) - wide_x * (1.0f / 24.0f) * (electric_value_xp2 - electric_value_xm1));
+		}
+	}
+}
+
+void FDTDCPU::update_electric_cell(int32_t x, int32_t y)
+{
+	size_t index = get_index(glm::ivec3(x, y, 0));
+
+	float wide_x = spatial_order == 4 ? electric_wide_x[index] : 0.0f;
+	float wide_y = spatial_order == 4 ? electric_wide_y[index] : 0.0f;
+
+	for (int32_t part = 0; part < part_count; part++) {
+		for (int32_t member = 0; member < ensemble_size; member++) {
+
+			float curl = 0;
+
+			if (electric_curl_mask[index] != 0) {
+				float magnetic_x00 = load_wrapped(magnetic_field_x, magnetic_field_x_imaginary, MagneticX, x, y, part, member);
+				float magnetic_x10 = load_wrapped(magnetic_field_x, magnetic_field_x_imaginary, MagneticX, x, y - 1, part, member);
+				float magnetic_y00 = load_wrapped(magnetic_field_y, magnetic_field_y_imaginary, MagneticY, x, y, part, member);
+				float magnetic_y01 = load_wrapped(magnetic_field_y, magnetic_field_y_imaginary, MagneticY, x - 1, y, part, member);
+
+				float magnetic_y_xp1 = 0, magnetic_y_xm2 = 0;
+				float magnetic_x_yp1 = 0, magnetic_x_ym2 = 0;
+
+				if (wide_x != 0) {
+					magnetic_y_xp1 = load_wrapped(magnetic_field_y, magnetic_field_y_imaginary, MagneticY, x + 1, y, part, member);
+					magnetic_y_xm2 = load_wrapped(magnetic_field_y, magnetic_field_y_imaginary, MagneticY, x - 2, y, part, member);
+				}
+
+				if (wide_y != 0) {
+					magnetic_x_yp1 = load_wrapped(magnetic_field_x, magnetic_field_x_imaginary, MagneticX, x, y + 1, part, member);
+					magnetic_x_ym2 = load_wrapped(magnetic_field_x, magnetic_field_x_imaginary, MagneticX, x, y - 2, part, member);
+				}
+
+				curl =
+					dt / (eps0 * dual_spacing_x[x]) * ((1.0f + wide_x * (1.0f / 8.0f)) * (magnetic_y00 - magnetic_y01) - wide_x * (1.0f / 24.0f) * (magnetic_y_xp1 - magnetic_y_xm2)) -
+					dt / (eps0 * dual_spacing_y[y]) * ((1.0f + wide_y * (1.0f / 8.0f)) * (magnetic_x00 - magnetic_x10) - wide_y * (1.0f / 24.0f) * (magnetic_x_yp1 - magnetic_x_ym2));
+			}
+
+			float& electric = electric_part(part)[index * ensemble_lanes + member];
+			electric = (electric_keep[index] * electric + electric_curl_mask[index] * curl) * electric_damp[index];
+		}
+	}
+}
+
+void FDTDCPU::apply_sources()
+{
+	for (int32_t part = 0; part < part_count; part++) {
+
+		std::vector<float>& electric = electric_part(part);
+
+		for (Source& source : sources) {
+
+			float value = source.voxel_type == FDTD::SourceImpulse ?
+				impulse_source_value(tick, part) :
+				sinusoidal_source_value(source.frequency, source.amplitude, source.phase, tick, dt, part);
+
+			electric[source.index * ensemble_lanes + source.member] += value * electric_damp[source.index];
+		}
+	}
+}
@@ -0,0 +1,223 @@
+#pragma once
+
+#include "FDTD.h"
+#include "WorkerPool.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+// cpu counterpart of FDTD (2D TMz: Ez, Hx, Hy)
+// follows the same voxel semantics, absorbing layer and tick convention as the compute shaders
+// so scenes and results can be compared directly.
+
+class FDTDCPU {
+public:
+
+	enum KernelVariant {
+		Reference	= 0,
+		Vectorized	= 1,
+		Tiled		= 2,		// Vectorized split into tile_size tiles over thread_count threads
+	};
+
+	enum FieldComponent {
+		ElectricZ	= 0,
+		MagneticX	= 1,
+		MagneticY	= 2,
+	};
+
+	// set before initialzie_fields(), same meaning as in FDTD
+	FDTD::BoundaryCondition boundary_condition_x = FDTD::Absorbing;
+	FDTD::BoundaryCondition boundary_condition_y = FDTD::Absorbing;
+	glm::vec3 bloch_wavevector = glm::vec3(0);
+	FDTD::Symmetry symmetry_x = FDTD::NoSymmetry;
+	FDTD::Symmetry symmetry_y = FDTD::NoSymmetry;
+	glm::ivec3 symmetry_plane = glm::ivec3(-1);
+	int32_t spatial_order = 2;
+	std::vector<float> graded_spacing_x;
+	std::vector<float> graded_spacing_y;
+
+	void initialzie_fields(
+		std::function<void(glm::ivec3, FDTD::ElectroMagneticProperty&)> initialization_lambda,
+		glm::ivec3 grid_resolution,
+		glm::ivec2 pml_thickness_x = glm::ivec2(10),
+		glm::ivec2 pml_thickness_y = glm::ivec2(10),
+		glm::ivec2 pml_thickness_z = glm::ivec2(10),
+		glm::vec3 grid_spacing = glm::vec3(2e-3f),
+		float courant_factor = 0			// 0 picks FDTD::compute_default_courant_factor(spatial_order)
+	);
+
+	// ensemble of scenarios that share one geometry (voxel types) and differ only in the frequency, amplitude
+	// or phase of their sources. every cell stores the fields of all members next to each other, so one vector
+	// operation updates a cell for the whole ensemble and the coefficients are loaded once for all members.
+	// member_initialization_lambdas holds one lambda per member, at most max_ensemble_lanes
+	void initialzie_fields(
+		const std::vector<std::function<void(glm::ivec3, FDTD::ElectroMagneticProperty&)>>& member_initialization_lambdas,
+		glm::ivec3 grid_resolution,
+		glm::ivec2 pml_thickness_x = glm::ivec2(10),
+		glm::ivec2 pml_thickness_y = glm::ivec2(10),
+		glm::ivec2 pml_thickness_z = glm::ivec2(10),
+		glm::vec3 grid_spacing = glm::vec3(2e-3f),
+		float courant_factor = 0			// 0 picks FDTD::compute_default_courant_factor(spatial_order)
+	);
+
+	void step();
+	void iterate_time(int32_t tick_count);
+
+	int32_t get_total_ticks_elapsed();
+	glm::ivec3 get_grid_resolution();			// simulated cells, the field vectors are laid out on this grid
+	glm::ivec3 get_full_grid_resolution();
+	glm::vec3 get_grid_spacing();			// finest spacing on graded axes
+	float get_timestep();
+	size_t get_index(glm::ivec3 id);
+	bool is_complex();
+	int32_t get_ensemble_size();
+	size_t get_field_index(glm::ivec3 id, int32_t member = 0);		// into the field vectors, get_index(id) without an ensemble
+
+	static constexpr int32_t max_ensemble_lanes = 16;
+
+	// fields of one ensemble member at full grid coordinates, unfolded through the symmetry planes
+	float get_electric_field(glm::ivec3 id, int32_t member = 0);
+	float get_magnetic_field_x(glm::ivec3 id, int32_t member = 0);
+	float get_magnetic_field_y(glm::ivec3 id, int32_t member = 0);
+	std::vector<float> get_unfolded_electric_field(int32_t member = 0);
+
+	// meters from node 0 of the full grid to every node along axis 0 (x) or 1 (y)
+	std::vector<float> get_node_positions(int32_t axis);
+
+	// field index and mirror sign a full grid value is read from, false for cells with no mirror image or off the grid
+	bool locate_unfolded(FieldComponent component, glm::ivec3 id, int32_t member, size_t& index, float& sign);
+
+	// warm start: a settled state of a neighbouring scene is loaded after initialzie_fields() on the same grid,
+	// an ensemble saves one member at a time and loads the state into every member
+	FieldState get_field_state(int32_t member = 0);
+	void load_field_state(const FieldState& state);
+
+	// same as FDTD::patch_properties(), fields and tick are kept. the update coefficients and sources of the
+	// patched cells are rebuilt, as are the fourth order masks that reach them. patches apply to every ensemble member,
+	// so on an ensemble they may not place sources
+	void patch_properties(const std::vector<FDTD::PropertyPatch>& patches);
+
+	// one patch list per ensemble member, e.g. FDTD::compute_property_patches() of every member's lambdas. members
+	// must keep sharing one geometry, a cell patched by some members only keeps its property in the others
+	void patch_properties(const std::vector<std::vector<FDTD::PropertyPatch>>& member_patches);
+
+	KernelVariant kernel_variant = Vectorized;
+	glm::ivec2 tile_size = glm::ivec2(0, 16);		// cells, 0 spans the whole axis
+	int32_t thread_count = 0;						// 0 uses every hardware thread
+
+	// set before initialzie_fields(), a matching entry in the profile overrides kernel_variant, tile_size
+	// and thread_count. with autotune_if_missing the FDTDAutotuner benchmarks the grid and stores the winner
+	std::string autotune_profile_path = "";
+	bool autotune_if_missing = false;
+
+	// laid out by get_field_index()
+	std::vector<float> electric_field;
+	std::vector<float> magnetic_field_x;
+	std::vector<float> magnetic_field_y;
+
+	// imaginary parts, only allocated when an axis is BlochPeriodic
+	std::vector<float> electric_field_imaginary;
+	std::vector<float> magnetic_field_x_imaginary;
+	std::vector<float> magnetic_field_y_imaginary;
+
+private:
+
+	struct Source {
+		size_t index;
+		int32_t member;
+		FDTD::VoxelType voxel_type;
+		float frequency;
+		float amplitude;
+		float phase;
+	};
+
+	void update_magnetic_reference();
+	void update_electric_reference();
+
+	void update_magnetic_vectorized();
+	void update_electric_vectorized();
+
+	void sweep_magnetic(glm::ivec2 begin, glm::ivec2 end);
+	void sweep_electric(glm::ivec2 begin, glm::ivec2 end);
+
+	// lane_count is ensemble_lanes
+	template<int32_t lane_count> void sweep_magnetic_lanes(glm::ivec2 begin, glm::ivec2 end);
+	template<int32_t lane_count> void sweep_electric_lanes(glm::ivec2 begin, glm::ivec2 end);
+	void for_each_tile(glm::ivec2 begin, glm::ivec2 end, const std::function<void(glm::ivec2, glm::ivec2)>& sweep);
+
+	void update_magnetic_cell(int32_t x, int32_t y);
+	void update_electric_cell(int32_t x, int32_t y);
+	void apply_sources();
+
+	void setup_electric_cell(int32_t x, int32_t y);
+	void add_sources(int32_t x, int32_t y);
+	void setup_stencil_masks(int32_t x, int32_t y);
+
+	bool is_periodic(int32_t axis);
+	bool is_symmetric(int32_t axis);
+	bool is_on_odd_symmetry_plane(int32_t x, int32_t y);
+	bool is_in_magnetic_update_domain(int32_t x, int32_t y);
+	bool is_in_electric_update_domain(int32_t x, int32_t y);
+	float load_wrapped(const std::vector<float>& real, const std::vector<float>& imaginary, FieldComponent component, int32_t x, int32_t y, int32_t part, int32_t member);
+	bool is_regular_cell(int32_t x, int32_t y);
+	bool is_in_absorbing_layer(int32_t x, int32_t y);
+	bool is_wide_stencil(int32_t x, int32_t y, glm::ivec2 direction, int32_t first, int32_t last);
+	float load_unfolded(const std::vector<float>& field, FieldComponent component, glm::ivec3 id, int32_t member);
+	float pml_damp_coefficient(glm::ivec3 coord);
+
+	std::vector<float>& electric_part(int32_t part);
+	std::vector<float>& magnetic_x_part(int32_t part);
+	std::vector<float>& magnetic_y_part(int32_t part);
+
+	glm::ivec3 grid_resolution = glm::ivec3(0);
+	glm::ivec3 full_grid_resolution = glm::ivec3(0);
+	glm::ivec3 symmetry_origin = glm::ivec3(0);
+	glm::ivec2 pml_thickness_x = glm::ivec2(0);
+	glm::ivec2 pml_thickness_y = glm::ivec2(0);
+	glm::ivec2 pml_thickness_z = glm::ivec2(0);
+
+	glm::vec3 grid_spacing = glm::vec3(0);
+	float dt = 0;
+
+	// per column (x) and row (y) of the simulated grid: spacing from an Ez node to the next one and between the
+	// magnetic nodes around it. the sweeps read the curl coefficients dt / (mu0 * node) and dt / (eps0 * dual)
+	std::vector<float> node_spacing_x;
+	std::vector<float> node_spacing_y;
+	std::vector<float> dual_spacing_x;
+	std::vector<float> dual_spacing_y;
+	std::vector<float> magnetic_coefficient_x;
+	std::vector<float> magnetic_coefficient_y;
+	std::vector<float> electric_coefficient_x;
+	std::vector<float> electric_coefficient_y;
+
+	// full grid
+	std::vector<float> node_positions_x;
+	std::vector<float> node_positions_y;
+
+	int32_t part_count = 1;
+	glm::vec2 bloch_phase = glm::vec2(0);
+	int32_t ensemble_size = 1;
+	int32_t ensemble_lanes = 1;			// ensemble_size rounded up to a power of two, lanes per cell in the field vectors
+
+	// interleaved like the fields, members only differ in their source parameters so the geometry is read from member 0
+	std::vector<FDTD::ElectroMagneticProperty> properties;
+
+	// precomputed per cell: Ez = (keep * Ez + curl_mask * curl(H) + source) * damp
+	std::vector<float> electric_keep;
+	std::vector<float> electric_curl_mask;
+	std::vector<float> electric_damp;
+
+	// fourth order stencil masks, only allocated when spatial_order is 4
+	std::vector<float> magnetic_wide_x;
+	std::vector<float> magnetic_wide_y;
+	std::vector<float> electric_wide_x;
+	std::vector<float> electric_wide_y;
+
+	std::vector<Source> sources;
+
+	// shared between copies so a solver stays copyable, copies must not step concurrently
+	std::shared_ptr<WorkerPool> worker_pool = nullptr;
+
+	int32_t tick = 0;
+};
@@ -0,0 +1,116 @@
+#include "FieldState.h"
+#include "GraphicsCortex.h"
+
+#include <cstring>
+#include <fstream>
+
+namespace {
+
+	constexpr char field_state_magic[4] = { 'G', 'Z', 'S', 'T' };
+	constexpr uint32_t field_state_version = 1;
+
+	template<typename T>
+	void write_value(std::ostream& stream, const T& value) {
+		stream.write((const char*)&value, sizeof(T));
+	}
+
+	template<typename T>
+	void read_value(std::istream& stream, T& value) {
+		stream.read((char*)&value, sizeof(T));
+	}
+
+	void write_array(std::ostream& stream, const std::vector<float>& values) {
+		stream.write((const char*)values.data(), values.size() * sizeof(float));
+	}
+
+	void read_array(std::istream& stream, std::vector<float>& values, size_t count) {
+		values.resize(count);
+		stream.read((char*)values.data(), count * sizeof(float));
+	}
+}
+
+bool FieldState::is_complex() const
+{
+	return !electric_field_imaginary.empty();
+}
+
+void FieldState::save(const std::string& filepath) const
+{
+	size_t cell_count = (size_t)grid_resolution.x * grid_resolution.y * grid_resolution.z;
+	size_t part_cell_count = is_complex() ? cell_count : 0;
+
+	if (electric_field.size() != cell_count || magnetic_field_x.size() != cell_count || magnetic_field_y.size() != cell_count ||
+		electric_field_imaginary.size() != part_cell_count || magnetic_field_x_imaginary.size() != part_cell_count || magnetic_field_y_imaginary.size() != part_cell_count
+	) {
+		std::cout << "[FDTD Error] FieldState::save() is called with fields that do not match grid_resolution" << std::endl;
+		ASSERT(false);
+	}
+
+	std::ofstream file(filepath, std::ios::binary | std::ios::trunc);
+	if (!file) {
+		std::cout << "[FDTD Error] FieldState::save() cannot write " << filepath << std::endl;
+		ASSERT(false);
+	}
+
+	uint32_t part_count = is_complex() ? 2 : 1;
+
+	file.write(field_state_magic, sizeof(field_state_magic));
+	write_value(file, field_state_version);
+	write_value(file, grid_resolution);
+	write_value(file, tick);
+	write_value(file, part_count);
+
+	write_array(file, electric_field);
+	write_array(file, magnetic_field_x);
+	write_array(file, magnetic_field_y);
+
+	if (is_complex()) {
+		write_array(file, electric_field_imaginary);
+		write_array(file, magnetic_field_x_imaginary);
+		write_array(file, magnetic_field_y_imaginary);
+	}
+}
+
+FieldState FieldState::load(const std::string& filepath)
+{
+	std::ifstream file(filepath, std::ios::binary);
+	if (!file) {
+		std::cout << "[FDTD Error] FieldState::load() cannot open " << filepath << std::endl;
+		ASSERT(false);
+	}
+
+	char magic[4];
+	uint32_t version;
+	file.read(magic, sizeof(magic));
+	read_value(file, version);
+
+	if (!file || std::memcmp(magic, field_state_magic, sizeof(magic)) != 0 || version != field_state_version) {
+		std::cout << "[FDTD Error] FieldState::load() " << filepath << " is not a field state" << std::endl;
+		ASSERT(false);
+	}
+
+	FieldState state;
+	uint32_t part_count;
+	read_value(file, state.grid_resolution);
+	read_value(file, state.tick);
+	read_value(file, part_count);
+
+	size_t cell_count = (size_t)state.grid_resolution.x * state.grid_resolution.y * state.grid_resolution.z;
+
+	read_array(file, state.electric_field, cell_count);
+	read_array(file, state.magnetic_field_x, cell_count);
+	read_array(file, state.magnetic_field_y, cell_count);
+
+	if (part_count == 2) {
+		read_array(file, state.electric_field_imaginary, cell_count);
+		read_array(file, state.magnetic_field_x_imaginary, cell_count);
+		read_array(file, state.magnetic_field_y_imaginary, cell_count);
+	}
+
+	if (!file || (part_count != 1 && part_count != 2)) {
+		std::cout << "[FDTD Error] FieldState::load() " << filepath << " is truncated" << std::endl;
+		ASSERT(false);
+	}
+
+	return state;
+}
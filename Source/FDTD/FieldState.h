@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "glm.hpp"
+
+// snapshot of the simulated fields and tick, taken from a settled run to warm start a slightly changed scene.
+// a neighbouring variant of a sweep loads the snapshot after initialzie_fields() instead of spending its
+// burn-in on transients from zero fields, only the difference between the scenes still has to settle.
+// vectors are laid out like FDTDCPU's fields, the imaginary parts are empty for real fields.
+
+struct FieldState {
+
+	glm::ivec3 grid_resolution = glm::ivec3(0);		// simulated cells
+	int32_t tick = 0;
+
+	std::vector<float> electric_field;
+	std::vector<float> magnetic_field_x;
+	std::vector<float> magnetic_field_y;
+
+	std::vector<float> electric_field_imaginary;
+	std::vector<float> magnetic_field_x_imaginary;
+	std::vector<float> magnetic_field_y_imaginary;
+
+	bool is_complex() const;
+
+	// raw binary, fields are stored exactly
+	void save(const std::string& filepath) const;
+	static FieldState load(const std::string& filepath);
+};
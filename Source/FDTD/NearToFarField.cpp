@@ -0,0 +1,237 @@
+#include "NearToFarField.h"
+#include "GraphicsCortex.h"
+#include "WorkerPool.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+	constexpr double pi		= 3.14159265358979323846264338327950288;
+	constexpr double c0		= 299792458.0;
+	constexpr double mu0	= 4.0 * pi * 1e-7;
+	constexpr double eta0	= mu0 * c0;
+
+	// outgoing wave for exp(i w t)
+	std::complex<double> hankel2(int32_t order, double argument) {
+		return std::complex<double>(std::cyl_bessel_j((double)order, argument), -std::cyl_neumann((double)order, argument));
+	}
+}
+
+NearToFarField::NearToFarField(FDTDCPU& solver, const std::vector<float>& frequencies) :
+	frequencies(frequencies.begin(), frequencies.end()),
+	node_positions_x(solver.get_node_positions(0)),
+	node_positions_y(solver.get_node_positions(1)),
+	dt(solver.get_timestep())
+{
+	if (frequencies.empty() || std::any_of(frequencies.begin(), frequencies.end(), [](float frequency) { return frequency <= 0; })) {
+		std::cout << "[FDTD Error] NearToFarField::NearToFarField() is called with invalid frequencies" << std::endl;
+		ASSERT(false);
+	}
+
+	if (solver.is_complex()) {
+		std::cout << "[FDTD Error] NearToFarField::NearToFarField() is called with a BlochPeriodic solver, the transform needs real fields in free space" << std::endl;
+		ASSERT(false);
+	}
+}
+
+void NearToFarField::add_face(glm::ivec2 begin, glm::ivec2 end, glm::ivec2 normal)
+{
+	bool along_x = begin.y == end.y;
+	bool along_y = begin.x == end.x;
+	bool normal_across = along_x ? (normal.x == 0 && std::abs(normal.y) == 1) : (normal.y == 0 && std::abs(normal.x) == 1);
+
+	if (!(along_x || along_y) || !normal_across || observed_tick_count != 0) {
+		std::cout << "[FDTD Error] NearToFarField::add_face() is called with a face that is not axis aligned, a normal along the face or after observe()" << std::endl;
+		ASSERT(false);
+	}
+
+	glm::ivec2 direction(along_x ? 1 : 0, along_x ? 0 : 1);
+	int32_t count = along_x ? std::abs(end.x - begin.x) + 1 : std::abs(end.y - begin.y) + 1;
+	glm::ivec2 first(std::min(begin.x, end.x), std::min(begin.y, end.y));
+	const std::vector<float>& positions = along_x ? node_positions_x : node_positions_y;
+	int32_t offset = along_x ? first.x : first.y;
+
+	// trapezoidal rule over the nodes of the face, every point carries half the distance to its neighbours on the face
+	for (int32_t i = 0; i < count; i++) {
+		int32_t node = offset + i;
+		float before = i > 0 ? positions[node] - positions[node - 1] : 0.0f;
+		float after = i < count - 1 ? positions[node + 1] - positions[node] : 0.0f;
+
+		SurfacePoint point;
+		point.cell = first + direction * i;
+		point.position = glm::vec2(node_positions_x[point.cell.x], node_positions_y[point.cell.y]);
+		point.normal = glm::vec2(normal.x, normal.y);
+		point.length = count > 1 ? 0.5f * (before + after) : positions[node + 1] - positions[node];
+		surface_points.push_back(point);
+	}
+
+	electric_dft.assign(surface_points.size() * frequencies.size(), 0.0);
+	current_dft.assign(surface_points.size() * frequencies.size(), 0.0);
+}
+
+void NearToFarField::add_rectangle(glm::ivec2 begin, glm::ivec2 end)
+{
+	if (end.x <= begin.x || end.y <= begin.y) {
+		std::cout << "[FDTD Error] NearToFarField::add_rectangle() is called with an empty rectangle" << std::endl;
+		ASSERT(false);
+	}
+
+	add_face(glm::ivec2(begin.x, begin.y), glm::ivec2(end.x, begin.y), glm::ivec2(0, -1));
+	add_face(glm::ivec2(begin.x, end.y), glm::ivec2(end.x, end.y), glm::ivec2(0, 1));
+	add_face(glm::ivec2(begin.x, begin.y), glm::ivec2(begin.x, end.y), glm::ivec2(-1, 0));
+	add_face(glm::ivec2(end.x, begin.y), glm::ivec2(end.x, end.y), glm::ivec2(1, 0));
+}
+
+void NearToFarField::observe(FDTDCPU& solver)
+{
+	// after a step Ez sits at tick * dt and H half a tick earlier
+	int32_t tick = solver.get_total_ticks_elapsed();
+	const size_t frequency_count = frequencies.size();
+
+	std::vector<std::complex<double>> electric_kernel(frequency_count);
+	std::vector<std::complex<double>> magnetic_kernel(frequency_count);
+
+	for (size_t f = 0; f < frequency_count; f++) {
+		double omega = 2.0 * pi * frequencies[f];
+		electric_kernel[f] = std::polar(1.0, -omega * tick * dt);
+		magnetic_kernel[f] = std::polar(1.0, -omega * (tick - 0.5) * dt);
+	}
+
+	for (size_t p = 0; p < surface_points.size(); p++) {
+
+		const SurfacePoint& point = surface_points[p];
+		glm::ivec3 id(point.cell.x, point.cell.y, 0);
+
+		// H components are half a cell off the Ez node across the face, average the two around it
+		double magnetic_x = 0.5 * ((double)solver.get_magnetic_field_x(id) + solver.get_magnetic_field_x(id - glm::ivec3(0, 1, 0)));
+		double magnetic_y = 0.5 * ((double)solver.get_magnetic_field_y(id) + solver.get_magnetic_field_y(id - glm::ivec3(1, 0, 0)));
+
+		double electric = solver.get_electric_field(id);
+		double current = point.normal.x * magnetic_y - point.normal.y * magnetic_x;
+
+		for (size_t f = 0; f < frequency_count; f++) {
+			electric_dft[p * frequency_count + f] += electric * electric_kernel[f];
+			current_dft[p * frequency_count + f] += current * magnetic_kernel[f];
+		}
+	}
+
+	observed_tick_count++;
+}
+
+int32_t NearToFarField::get_observed_tick_count()
+{
+	return observed_tick_count;
+}
+
+int32_t NearToFarField::get_surface_point_count()
+{
+	return (int32_t)surface_points.size();
+}
+
+// Ez(r) = sum over the faces of (-w mu / 4 * Jz * H0(2)(k R) - i k / 4 * H1(2)(k R) * (R^ x M).z) * length
+std::vector<std::complex<double>> NearToFarField::compute_electric_field(int32_t frequency_index, const std::vector<glm::vec2>& positions, int32_t thread_count)
+{
+	check_frequency_index(frequency_index);
+
+	const size_t frequency_count = frequencies.size();
+	const double omega = 2.0 * pi * frequencies[frequency_index];
+	const double k = omega / c0;
+	const double normalization = 2.0 / std::max(observed_tick_count, 1);
+
+	return evaluate_parallel(positions.size(), thread_count, [&](size_t i) {
+
+		std::complex<double> field = 0;
+
+		for (size_t p = 0; p < surface_points.size(); p++) {
+
+			const SurfacePoint& point = surface_points[p];
+
+			double delta_x = (double)positions[i].x - point.position.x;
+			double delta_y = (double)positions[i].y - point.position.y;
+			double distance = std::sqrt(delta_x * delta_x + delta_y * delta_y);
+
+			if (distance == 0)
+				continue;
+
+			std::complex<double> electric = electric_dft[p * frequency_count + frequency_index];
+			std::complex<double> current = current_dft[p * frequency_count + frequency_index];
+
+			// M = -n x (Ez z^) = (-n.y * Ez, n.x * Ez), (R^ x M).z = Ez * (R^ . n)
+			double direction_dot_normal = (delta_x * point.normal.x + delta_y * point.normal.y) / distance;
+
+			field += (double)point.length * (
+				-omega * mu0 / 4.0 * current * hankel2(0, k * distance) -
+				std::complex<double>(0, k / 4.0) * hankel2(1, k * distance) * direction_dot_normal * electric);
+		}
+
+		return field * normalization;
+	});
+}
+
+// H0(2)(k R) ~ sqrt(2 / (pi k r)) * exp(-i (k r - pi / 4)) * exp(i k r^ . r') and H1(2) ~ i * H0(2) in the far zone
+std::vector<std::complex<double>> NearToFarField::compute_far_field_pattern(int32_t frequency_index, const std::vector<float>& angles, glm::vec2 origin, int32_t thread_count)
+{
+	check_frequency_index(frequency_index);
+
+	const size_t frequency_count = frequencies.size();
+	const double omega = 2.0 * pi * frequencies[frequency_index];
+	const double k = omega / c0;
+	const double normalization = 2.0 / std::max(observed_tick_count, 1);
+	const std::complex<double> asymptotic = std::sqrt(2.0 / (pi * k)) * std::polar(1.0, pi / 4.0);
+
+	return evaluate_parallel(angles.size(), thread_count, [&](size_t i) {
+
+		double direction_x = std::cos((double)angles[i]);
+		double direction_y = std::sin((double)angles[i]);
+
+		std::complex<double> pattern = 0;
+
+		for (size_t p = 0; p < surface_points.size(); p++) {
+
+			const SurfacePoint& point = surface_points[p];
+
+			std::complex<double> electric = electric_dft[p * frequency_count + frequency_index];
+			std::complex<double> current = current_dft[p * frequency_count + frequency_index];
+
+			double direction_dot_normal = direction_x * point.normal.x + direction_y * point.normal.y;
+			double path_difference = direction_x * ((double)point.position.x - origin.x) + direction_y * ((double)point.position.y - origin.y);
+
+			pattern += (double)point.length * (-omega * mu0 / 4.0 * current + k / 4.0 * direction_dot_normal * electric) *
+				std::polar(1.0, k * path_difference);
+		}
+
+		return pattern * asymptotic * normalization;
+	});
+}
+
+double NearToFarField::compute_radiation_intensity(std::complex<double> pattern)
+{
+	return std::norm(pattern) / (2.0 * eta0);
+}
+
+// every output is an independent surface integral, chunks of them are spread over a worker pool
+template<typename Evaluate>
+std::vector<std::complex<double>> NearToFarField::evaluate_parallel(size_t count, int32_t thread_count, Evaluate evaluate)
+{
+	const size_t chunk_size = 16;
+	const int32_t chunk_count = (int32_t)((count + chunk_size - 1) / chunk_size);
+
+	std::vector<std::complex<double>> result(count);
+
+	WorkerPool pool(thread_count > 0 ? thread_count : WorkerPool::get_hardware_thread_count());
+	pool.run(chunk_count, [&](int32_t chunk) {
+		size_t end = std::min(count, (chunk + 1) * chunk_size);
+		for (size_t i = chunk * chunk_size; i < end; i++)
+			result[i] = evaluate(i);
+		});
+
+	return result;
+}
+
+void NearToFarField::check_frequency_index(int32_t frequency_index)
+{
+	if (frequency_index < 0 || frequency_index >= (int32_t)frequencies.size()) {
+		std::cout << "[FDTD Error] NearToFarField is called with invalid frequency_index" << std::endl;
+		ASSERT(false);
+	}
+}
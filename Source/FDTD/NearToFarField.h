@@ -0,0 +1,70 @@
+#pragma once
+
+#include "FDTDCPU.h"
+
+#include <complex>
+#include <vector>
+
+// near to far field transform for the 2D TMz fields of FDTDCPU.
+// a running DFT of Ez and the tangential H is kept on faces of Ez nodes, afterwards the equivalent currents
+// J = n x H and M = -n x E radiate through the free space 2D Green's function -i/4 * H0(2)(k r) to any point
+// or, asymptotically, to any angle. faces either close a contour around every scatterer and source (the field
+// outside is reproduced, inside it vanishes) or form an aperture line spanning the grid, which reproduces the
+// field in the half space the normal points to as long as the line ends in the absorbing layer.
+// phasors follow exp(i w t): a sampled x(t) = Re(X * exp(i w t)).
+
+class NearToFarField {
+public:
+
+	// frequencies in Hz, the solver provides node positions and timestep
+	NearToFarField(FDTDCPU& solver, const std::vector<float>& frequencies);
+
+	// straight run of Ez nodes from begin to end (full grid coordinates, inclusive) along x or y,
+	// normal is a unit axis vector pointing to the side being reconstructed
+	void add_face(glm::ivec2 begin, glm::ivec2 end, glm::ivec2 normal);
+
+	// four faces with outward normals, corners are shared
+	void add_rectangle(glm::ivec2 begin, glm::ivec2 end);
+
+	// call once per tick after solver.step(), only ticks spanning whole periods give exact phasors
+	void observe(FDTDCPU& solver);
+
+	int32_t get_observed_tick_count();
+	int32_t get_surface_point_count();
+
+	// Ez phasor at points in meters measured from Ez node (0, 0) of the full grid, evaluated with the exact Green's function
+	std::vector<std::complex<double>> compute_electric_field(int32_t frequency_index, const std::vector<glm::vec2>& positions, int32_t thread_count = 0);
+
+	// Ez ~ pattern(angle) * exp(-i k r) / sqrt(r) for r -> inf, r measured from origin in meters. angles in radians from +x
+	std::vector<std::complex<double>> compute_far_field_pattern(int32_t frequency_index, const std::vector<float>& angles, glm::vec2 origin, int32_t thread_count = 0);
+
+	// |pattern|^2 / (2 * eta), time averaged power per radian carried to angle by the phasor field
+	static double compute_radiation_intensity(std::complex<double> pattern);
+
+private:
+
+	struct SurfacePoint {
+		glm::ivec2 cell;
+		glm::vec2 position;
+		glm::vec2 normal;
+		float length;
+	};
+
+	template<typename Evaluate>
+	std::vector<std::complex<double>> evaluate_parallel(size_t count, int32_t thread_count, Evaluate evaluate);
+
+	void check_frequency_index(int32_t frequency_index);
+
+	std::vector<double> frequencies;
+	std::vector<float> node_positions_x;		// meters, full grid
+	std::vector<float> node_positions_y;
+	float dt;
+
+	std::vector<SurfacePoint> surface_points;
+
+	// [point * frequency_count + frequency]
+	std::vector<std::complex<double>> electric_dft;
+	std::vector<std::complex<double>> current_dft;		// Jz = (n x H).z
+
+	int32_t observed_tick_count = 0;
+};
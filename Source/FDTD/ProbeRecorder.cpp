@@ -0,0 +1,394 @@
+#include "ProbeRecorder.h"
+#include "GraphicsCortex.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+namespace {
+
+	constexpr char probe_series_magic[4] = { 'G', 'Z', 'P', 'R' };
+	constexpr uint32_t probe_series_version = 1;
+
+	template<typename T>
+	void write_value(std::ostream& stream, const T& value) {
+		stream.write((const char*)&value, sizeof(T));
+	}
+
+	template<typename T>
+	void read_value(std::istream& stream, T& value) {
+		stream.read((char*)&value, sizeof(T));
+	}
+
+	const char* component_name(FDTDCPU::FieldComponent component) {
+		switch (component) {
+		case FDTDCPU::ElectricZ:	return "Ez";
+		case FDTDCPU::MagneticX:	return "Hx";
+		case FDTDCPU::MagneticY:	return "Hy";
+		}
+		return "unknown";
+	}
+
+	// where the nodes of a component sit relative to the Ez node of the same cell
+	glm::vec2 node_offset(FDTDCPU::FieldComponent component) {
+		return glm::vec2(component == FDTDCPU::MagneticY ? 0.5f : 0.0f, component == FDTDCPU::MagneticX ? 0.5f : 0.0f);
+	}
+}
+
+int32_t ProbeSeries::get_row_count() const
+{
+	return (int32_t)ticks.size();
+}
+
+ProbeSeries ProbeSeries::load(const std::string& filepath)
+{
+	std::ifstream file(filepath, std::ios::binary);
+	if (!file) {
+		std::cout << "[FDTD Error] ProbeSeries::load() cannot open " << filepath << std::endl;
+		ASSERT(false);
+	}
+
+	char magic[4];
+	uint32_t version;
+	file.read(magic, sizeof(magic));
+	read_value(file, version);
+
+	if (!file || std::memcmp(magic, probe_series_magic, sizeof(magic)) != 0 || version != probe_series_version) {
+		std::cout << "[FDTD Error] ProbeSeries::load() " << filepath << " is not a probe series" << std::endl;
+		ASSERT(false);
+	}
+
+	ProbeSeries series;
+	int32_t channel_count;
+	read_value(file, series.dt);
+	read_value(file, channel_count);
+
+	series.channels.resize(std::max(channel_count, 0));
+	for (Channel& channel : series.channels) {
+		int32_t component;
+		read_value(file, component);
+		read_value(file, channel.member);
+		read_value(file, channel.position);
+		channel.component = (FDTDCPU::FieldComponent)component;
+	}
+
+	// rows run until the end of the file, a file flushed mid run holds whole rows only
+	std::streamoff rows_begin = file.tellg();
+	file.seekg(0, std::ios::end);
+	std::streamoff row_size = sizeof(int32_t) + series.channels.size() * sizeof(float);
+	std::streamoff rows_size = file.tellg() - rows_begin;
+	file.seekg(rows_begin);
+
+	if (!file || rows_size % row_size != 0) {
+		std::cout << "[FDTD Error] ProbeSeries::load() " << filepath << " is truncated" << std::endl;
+		ASSERT(false);
+	}
+
+	size_t row_count = (size_t)(rows_size / row_size);
+	series.ticks.resize(row_count);
+	series.samples.resize(row_count * series.channels.size());
+
+	for (size_t row = 0; row < row_count; row++) {
+		read_value(file, series.ticks[row]);
+		file.read((char*)(series.samples.data() + row * series.channels.size()), series.channels.size() * sizeof(float));
+	}
+
+	return series;
+}
+
+ProbeRecorder::ProbeRecorder(FDTDCPU& solver, const std::string& filepath, Format format, int32_t ring_ticks) :
+	solver(solver),
+	format(format),
+	ring_ticks(ring_ticks),
+	wake_rows(std::max(ring_ticks / 4, 1))
+{
+	if (ring_ticks <= 0) {
+		std::cout << "[FDTD Error] ProbeRecorder::ProbeRecorder() is called with invalid ring_ticks" << std::endl;
+		ASSERT(false);
+	}
+
+	file.open(filepath, format == Binary ? std::ios::binary | std::ios::trunc : std::ios::trunc);
+	if (!file) {
+		std::cout << "[FDTD Error] ProbeRecorder::ProbeRecorder() cannot open " << filepath << std::endl;
+		ASSERT(false);
+	}
+
+	file.precision(std::numeric_limits<float>::max_digits10);
+}
+
+ProbeRecorder::~ProbeRecorder()
+{
+	close();
+}
+
+int32_t ProbeRecorder::add_point(glm::ivec2 cell, FDTDCPU::FieldComponent component, int32_t member)
+{
+	return add_channel(glm::vec2(cell.x, cell.y), false, component, member);
+}
+
+int32_t ProbeRecorder::add_point(glm::vec2 position, FDTDCPU::FieldComponent component, int32_t member)
+{
+	return add_channel(position, true, component, member);
+}
+
+int32_t ProbeRecorder::add_line(glm::vec2 begin, glm::vec2 end, int32_t sample_count, FDTDCPU::FieldComponent component, int32_t member)
+{
+	if (sample_count <= 0) {
+		std::cout << "[FDTD Error] ProbeRecorder::add_line() is called with invalid sample_count" << std::endl;
+		ASSERT(false);
+	}
+
+	int32_t first_channel = (int32_t)channels.size();
+
+	for (int32_t i = 0; i < sample_count; i++) {
+		float t = sample_count > 1 ? (float)i / (sample_count - 1) : 0.0f;
+		add_channel(glm::vec2(begin.x + (end.x - begin.x) * t, begin.y + (end.y - begin.y) * t), true, component, member);
+	}
+
+	return first_channel;
+}
+
+int32_t ProbeRecorder::add_box(glm::ivec2 begin, glm::ivec2 end, FDTDCPU::FieldComponent component, int32_t member)
+{
+	if (end.x < begin.x || end.y < begin.y) {
+		std::cout << "[FDTD Error] ProbeRecorder::add_box() is called with an empty box" << std::endl;
+		ASSERT(false);
+	}
+
+	int32_t first_channel = (int32_t)channels.size();
+
+	for (int32_t y = begin.y; y <= end.y; y++)
+		for (int32_t x = begin.x; x <= end.x; x++)
+			add_channel(glm::vec2(x, y), false, component, member);
+
+	return first_channel;
+}
+
+// a channel is the weighted sum of its taps, the weights carry the mirror sign of cells before a symmetry plane
+int32_t ProbeRecorder::add_channel(glm::vec2 position, bool interpolated, FDTDCPU::FieldComponent component, int32_t member)
+{
+	glm::ivec3 full_grid_resolution = solver.get_full_grid_resolution();
+
+	if (started || !file.is_open()) {
+		std::cout << "[FDTD Error] ProbeRecorder is called to add a probe after observe() or close()" << std::endl;
+		ASSERT(false);
+	}
+
+	if (position.x < 0 || position.y < 0 || position.x > full_grid_resolution.x - 1 || position.y > full_grid_resolution.y - 1 ||
+		member < 0 || member >= solver.get_ensemble_size()
+	) {
+		std::cout << "[FDTD Error] ProbeRecorder is called with a probe outside the grid or an invalid member" << std::endl;
+		ASSERT(false);
+	}
+
+	size_t index;
+	float sign;
+
+	if (!interpolated) {
+		if (solver.locate_unfolded(component, glm::ivec3((int32_t)position.x, (int32_t)position.y, 0), member, index, sign))
+			taps.push_back({ index, sign });
+	}
+	else {
+		glm::vec2 node = position - node_offset(component);
+		glm::ivec2 base((int32_t)std::floor(node.x), (int32_t)std::floor(node.y));
+		glm::vec2 fraction(node.x - base.x, node.y - base.y);
+
+		for (int32_t dy = 0; dy < 2; dy++) {
+			for (int32_t dx = 0; dx < 2; dx++) {
+				float weight = (dx == 1 ? fraction.x : 1.0f - fraction.x) * (dy == 1 ? fraction.y : 1.0f - fraction.y);
+				if (weight != 0 && solver.locate_unfolded(component, glm::ivec3(base.x + dx, base.y + dy, 0), member, index, sign))
+					taps.push_back({ index, sign * weight });
+			}
+		}
+	}
+
+	ProbeSeries::Channel channel;
+	channel.component = component;
+	channel.member = member;
+	channel.position = position;
+
+	channels.push_back(channel);
+	channel_tap_end.push_back((int32_t)taps.size());
+
+	return (int32_t)channels.size() - 1;
+}
+
+void ProbeRecorder::observe()
+{
+	if (!file.is_open()) {
+		std::cout << "[FDTD Error] ProbeRecorder::observe() is called after close()" << std::endl;
+		ASSERT(false);
+	}
+
+	if (!started)
+		start();
+
+	uint64_t row = observed_rows.load(std::memory_order_relaxed);
+
+	if (row - written_rows.load(std::memory_order_acquire) == (uint64_t)ring_ticks) {
+		std::unique_lock<std::mutex> lock(mutex);
+		rows_ready.notify_one();
+		rows_written.wait(lock, [&]() { return row - written_rows.load(std::memory_order_acquire) < (uint64_t)ring_ticks; });
+		waited_tick_count++;
+	}
+
+	const float* fields[3] = { solver.electric_field.data(), solver.magnetic_field_x.data(), solver.magnetic_field_y.data() };
+	float* samples = ring_samples.data() + (row % ring_ticks) * channels.size();
+	int32_t tap = 0;
+
+	for (size_t c = 0; c < channels.size(); c++) {
+		const float* field = fields[channels[c].component];
+		float value = 0;
+
+		for (; tap < channel_tap_end[c]; tap++)
+			value += taps[tap].weight * field[taps[tap].index];
+
+		samples[c] = value;
+	}
+
+	ring_tick_numbers[row % ring_ticks] = solver.get_total_ticks_elapsed();
+
+	// observed_rows and writer_waiting are sequentially consistent on both sides: either this sees the writer
+	// waiting, or the writer sees the new row before it sleeps. a sleeping writer is woken up once wake_rows are pending
+	observed_rows.store(row + 1);
+
+	if (row + 1 - written_rows.load(std::memory_order_acquire) >= (uint64_t)wake_rows && writer_waiting.load()) {
+		std::lock_guard<std::mutex> lock(mutex);
+		rows_ready.notify_one();
+	}
+}
+
+void ProbeRecorder::flush()
+{
+	if (!started)
+		return;
+
+	std::unique_lock<std::mutex> lock(mutex);
+	flush_requested = true;
+	rows_ready.notify_one();
+	rows_written.wait(lock, [&]() { return written_rows.load(std::memory_order_acquire) == observed_rows.load(std::memory_order_relaxed); });
+	flush_requested = false;
+
+	// the writer is idle until the next observe()
+	file.flush();
+}
+
+void ProbeRecorder::close()
+{
+	if (!file.is_open())
+		return;
+
+	if (started) {
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			stopping = true;
+		}
+		rows_ready.notify_one();
+		writer.join();
+	}
+	else
+		write_header();
+
+	file.close();
+}
+
+int32_t ProbeRecorder::get_channel_count()
+{
+	return (int32_t)channels.size();
+}
+
+int32_t ProbeRecorder::get_observed_tick_count()
+{
+	return (int32_t)observed_rows.load(std::memory_order_relaxed);
+}
+
+int32_t ProbeRecorder::get_waited_tick_count()
+{
+	return waited_tick_count;
+}
+
+void ProbeRecorder::start()
+{
+	ring_samples.assign((size_t)ring_ticks * channels.size(), 0);
+	ring_tick_numbers.assign(ring_ticks, 0);
+
+	write_header();
+
+	started = true;
+	writer = std::thread(&ProbeRecorder::writer_loop, this);
+}
+
+void ProbeRecorder::write_header()
+{
+	if (format == Binary) {
+		file.write(probe_series_magic, sizeof(probe_series_magic));
+		write_value(file, probe_series_version);
+		write_value(file, solver.get_timestep());
+		write_value(file, (int32_t)channels.size());
+
+		for (ProbeSeries::Channel& channel : channels) {
+			write_value(file, (int32_t)channel.component);
+			write_value(file, channel.member);
+			write_value(file, channel.position);
+		}
+		return;
+	}
+
+	file << "tick";
+	for (ProbeSeries::Channel& channel : channels) {
+		file << ',' << component_name(channel.component) << '(' << channel.position.x << ' ' << channel.position.y << ')';
+		if (solver.get_ensemble_size() > 1)
+			file << '[' << channel.member << ']';
+	}
+	file << '\n';
+}
+
+void ProbeRecorder::writer_loop()
+{
+	std::unique_lock<std::mutex> lock(mutex);
+
+	while (true) {
+		writer_waiting.store(true);
+		rows_ready.wait(lock, [&]() {
+			uint64_t pending = observed_rows.load() - written_rows.load(std::memory_order_relaxed);
+			return pending >= (uint64_t)wake_rows || (pending != 0 && flush_requested) || stopping;
+			});
+		writer_waiting.store(false);
+
+		uint64_t begin = written_rows.load(std::memory_order_relaxed);
+		uint64_t end = observed_rows.load(std::memory_order_acquire);
+
+		if (begin == end && stopping)
+			break;
+
+		lock.unlock();
+		write_rows(begin, end);
+		lock.lock();
+
+		written_rows.store(end, std::memory_order_release);
+		rows_written.notify_all();
+	}
+}
+
+void ProbeRecorder::write_rows(uint64_t begin, uint64_t end)
+{
+	const size_t channel_count = channels.size();
+
+	for (uint64_t row = begin; row < end; row++) {
+
+		const float* samples = ring_samples.data() + (row % ring_ticks) * channel_count;
+		int32_t tick = ring_tick_numbers[row % ring_ticks];
+
+		if (format == Binary) {
+			write_value(file, tick);
+			file.write((const char*)samples, channel_count * sizeof(float));
+			continue;
+		}
+
+		file << tick;
+		for (size_t c = 0; c < channel_count; c++)
+			file << ',' << samples[c];
+		file << '\n';
+	}
+}
@@ -0,0 +1,118 @@
+#pragma once
+
+#include "FDTDCPU.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// time domain detector signals of FDTDCPU without full field output.
+// probes are points, interpolated points, lines and boxes of one field component, every value they sample is
+// a channel. observe() reads all channels into the next row of a ring buffer allocated once, a background
+// thread drains the ring to a binary or csv stream. observe() only waits when the writer falls a whole ring behind.
+// real parts are sampled. observe(), flush() and close() belong to the thread stepping the solver.
+
+// binary probe file read back in full
+struct ProbeSeries {
+
+	struct Channel {
+		FDTDCPU::FieldComponent component = FDTDCPU::ElectricZ;
+		int32_t member = 0;
+		glm::vec2 position = glm::vec2(0);		// cells of the full grid
+	};
+
+	float dt = 0;								// Ez of a row sits at tick * dt, H half a tick earlier
+	std::vector<Channel> channels;
+	std::vector<int32_t> ticks;
+	std::vector<float> samples;					// [row * channel_count + channel]
+
+	int32_t get_row_count() const;
+
+	static ProbeSeries load(const std::string& filepath);
+};
+
+class ProbeRecorder {
+public:
+
+	enum Format {
+		Binary	= 0,		// read back with ProbeSeries::load()
+		CSV		= 1,		// a tick column and one column per channel
+	};
+
+	// the solver is initialized and outlives the recorder, ring_ticks rows are buffered between observe() and the writer
+	ProbeRecorder(FDTDCPU& solver, const std::string& filepath, Format format = Binary, int32_t ring_ticks = 1024);
+	~ProbeRecorder();
+
+	ProbeRecorder(const ProbeRecorder&) = delete;
+	ProbeRecorder& operator=(const ProbeRecorder&) = delete;
+
+	// probes return their first channel, cells are full grid coordinates like FDTDCPU::get_electric_field()
+	int32_t add_point(glm::ivec2 cell, FDTDCPU::FieldComponent component, int32_t member = 0);
+
+	// position in cells of the full grid, bilinear between the four nearest nodes of the component.
+	// Hx nodes sit half a cell up in y, Hy nodes half a cell right in x
+	int32_t add_point(glm::vec2 position, FDTDCPU::FieldComponent component, int32_t member = 0);
+
+	// sample_count interpolated points spaced evenly from begin to end
+	int32_t add_line(glm::vec2 begin, glm::vec2 end, int32_t sample_count, FDTDCPU::FieldComponent component, int32_t member = 0);
+
+	// every cell from begin to end inclusive, x fastest
+	int32_t add_box(glm::ivec2 begin, glm::ivec2 end, FDTDCPU::FieldComponent component, int32_t member = 0);
+
+	// call once per tick after solver.step(), probes can't be added after the first call
+	void observe();
+
+	// returns once every observed tick is in the file
+	void flush();
+	void close();
+
+	int32_t get_channel_count();
+	int32_t get_observed_tick_count();
+	int32_t get_waited_tick_count();		// ticks observe() waited on a full ring
+
+private:
+
+	struct Tap {
+		size_t index;
+		float weight;
+	};
+
+	int32_t add_channel(glm::vec2 position, bool interpolated, FDTDCPU::FieldComponent component, int32_t member);
+
+	void start();
+	void write_header();
+	void writer_loop();
+	void write_rows(uint64_t begin, uint64_t end);
+
+	FDTDCPU& solver;
+	std::ofstream file;
+	Format format;
+	int32_t ring_ticks;
+	int32_t wake_rows;						// rows pending before the writer is woken up
+
+	std::vector<ProbeSeries::Channel> channels;
+	std::vector<Tap> taps;
+	std::vector<int32_t> channel_tap_end;	// taps of channel c are [channel_tap_end[c - 1], channel_tap_end[c])
+
+	// [row % ring_ticks * channel_count + channel]
+	std::vector<float> ring_samples;
+	std::vector<int32_t> ring_tick_numbers;
+
+	std::thread writer;
+	std::mutex mutex;
+	std::condition_variable rows_ready;
+	std::condition_variable rows_written;
+
+	std::atomic<uint64_t> observed_rows{ 0 };
+	std::atomic<uint64_t> written_rows{ 0 };
+	std::atomic<bool> writer_waiting{ false };	// set by the writer under the mutex before it sleeps on rows_ready
+	bool started = false;
+	bool stopping = false;
+	bool flush_requested = false;
+
+	int32_t waited_tick_count = 0;
+};
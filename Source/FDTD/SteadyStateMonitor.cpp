@@ -0,0 +1,154 @@
+#include "SteadyStateMonitor.h"
+#include "GraphicsCortex.h"
+
+#include <algorithm>
+#include <cmath>
+
+SteadyStateMonitor::SteadyStateMonitor(
+	float period_ticks,
+	float transient_tolerance,
+	float convergence_tolerance,
+	int32_t settled_window_count
+) :
+	transient_tolerance(transient_tolerance),
+	convergence_tolerance(convergence_tolerance),
+	settled_window_count(settled_window_count)
+{
+	if (period_ticks <= 0 || transient_tolerance <= 0 || convergence_tolerance <= 0 || settled_window_count <= 0) {
+		std::cout << "[FDTD Error] SteadyStateMonitor::SteadyStateMonitor() is called with invalid parameters" << std::endl;
+		ASSERT(false);
+	}
+
+	float period_count = std::ceil(minimum_window_ticks / period_ticks);
+	window_ticks = std::max(1, (int32_t)std::lround(period_count * period_ticks));
+}
+
+float SteadyStateMonitor::compute_period_ticks(float source_frequency, float dt)
+{
+	return 1.0f / (source_frequency * dt);
+}
+
+SteadyStateMonitor::State SteadyStateMonitor::observe(const float* values, size_t count)
+{
+	if (window_intensity.size() != count) {
+		window_intensity.assign(count, 0.0);
+		previous_window_intensity.clear();
+		accumulated_mean.clear();
+		previous_accumulated_mean.clear();
+	}
+
+	State tick_state = state;
+
+	if (state != Converged) {
+		for (size_t i = 0; i < count; i++)
+			window_intensity[i] += (double)values[i] * values[i];
+
+		window_tick++;
+		if (window_tick == window_ticks)
+			close_window();
+	}
+
+	ticks_observed++;
+	return tick_state;
+}
+
+SteadyStateMonitor::State SteadyStateMonitor::observe(const std::vector<float>& values)
+{
+	return observe(values.data(), values.size());
+}
+
+void SteadyStateMonitor::close_window()
+{
+	for (double& value : window_intensity)
+		value /= window_ticks;
+
+	if (state == Transient) {
+
+		bool settled = !previous_window_intensity.empty() && relative_change(window_intensity, previous_window_intensity) < transient_tolerance;
+		settled_windows = settled ? settled_windows + 1 : 0;
+
+		if (settled_windows >= settled_window_count) {
+			state = Accumulating;
+			accumulation_begin_tick = ticks_observed + 1;
+			settled_windows = 0;
+		}
+	}
+	else if (state == Accumulating) {
+
+		accumulated_windows++;
+
+		if (accumulated_mean.empty())
+			accumulated_mean.assign(window_intensity.size(), 0.0);
+
+		previous_accumulated_mean = accumulated_mean;
+		for (size_t i = 0; i < accumulated_mean.size(); i++)
+			accumulated_mean[i] += (window_intensity[i] - accumulated_mean[i]) / accumulated_windows;
+
+		bool settled = accumulated_windows > 1 && relative_change(accumulated_mean, previous_accumulated_mean) < convergence_tolerance;
+		settled_windows = settled ? settled_windows + 1 : 0;
+
+		if (settled_windows >= settled_window_count)
+			state = Converged;
+	}
+
+	std::swap(previous_window_intensity, window_intensity);
+	window_intensity.assign(previous_window_intensity.size(), 0.0);
+	window_tick = 0;
+}
+
+float SteadyStateMonitor::relative_change(const std::vector<double>& current, const std::vector<double>& previous)
+{
+	double difference = 0;
+	double norm = 0;
+
+	for (size_t i = 0; i < current.size(); i++) {
+		difference += (current[i] - previous[i]) * (current[i] - previous[i]);
+		norm += current[i] * current[i];
+	}
+
+	// nothing has reached the monitored samples yet
+	if (norm == 0)
+		return 1.0f;
+
+	return (float)std::sqrt(difference / norm);
+}
+
+SteadyStateMonitor::State SteadyStateMonitor::get_state()
+{
+	return state;
+}
+
+bool SteadyStateMonitor::should_accumulate()
+{
+	return state == Accumulating;
+}
+
+bool SteadyStateMonitor::is_converged()
+{
+	return state == Converged;
+}
+
+int32_t SteadyStateMonitor::get_ticks_observed()
+{
+	return ticks_observed;
+}
+
+int32_t SteadyStateMonitor::get_accumulation_begin_tick()
+{
+	return accumulation_begin_tick;
+}
+
+int32_t SteadyStateMonitor::get_accumulated_tick_count()
+{
+	return accumulated_windows * window_ticks;
+}
+
+int32_t SteadyStateMonitor::get_window_ticks()
+{
+	return window_ticks;
+}
+
+int32_t SteadyStateMonitor::get_ticks_saved(int32_t max_ticks)
+{
+	return std::max(0, max_ticks - ticks_observed);
+}
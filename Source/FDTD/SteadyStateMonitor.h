@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// watches a handful of sampled field values once per tick and decides when a time harmonic run has settled.
+// samples are squared and summed over windows of whole source periods (the fewest that cover
+// minimum_window_ticks, so a fractional period in ticks barely biases a window). once consecutive window
+// intensities stop changing the monitor switches to Accumulating on a window boundary, and once the running
+// mean of the accumulated windows stops changing it reports Converged.
+
+class SteadyStateMonitor {
+public:
+
+	enum State {
+		Transient		= 0,
+		Accumulating	= 1,
+		Converged		= 2,
+	};
+
+	SteadyStateMonitor(
+		float period_ticks,
+		float transient_tolerance = 1e-2f,
+		float convergence_tolerance = 1e-3f,
+		int32_t settled_window_count = 2
+	);
+
+	// source frequency in Hz
+	static float compute_period_ticks(float source_frequency, float dt);
+
+	static constexpr int32_t minimum_window_ticks = 64;
+
+	// returns the state for the tick the values were sampled at
+	State observe(const float* values, size_t count);
+	State observe(const std::vector<float>& values);
+
+	State get_state();
+	bool should_accumulate();
+	bool is_converged();
+
+	int32_t get_ticks_observed();
+	int32_t get_accumulation_begin_tick();
+	int32_t get_accumulated_tick_count();
+	int32_t get_window_ticks();
+	int32_t get_ticks_saved(int32_t max_ticks);
+
+private:
+
+	float relative_change(const std::vector<double>& current, const std::vector<double>& previous);
+	void close_window();
+
+	int32_t window_ticks;
+	float transient_tolerance;
+	float convergence_tolerance;
+	int32_t settled_window_count;
+
+	State state = Transient;
+	int32_t ticks_observed = 0;
+	int32_t accumulation_begin_tick = -1;
+
+	int32_t window_tick = 0;
+	int32_t settled_windows = 0;
+	int32_t accumulated_windows = 0;
+
+	std::vector<double> window_intensity;
+	std::vector<double> previous_window_intensity;
+	std::vector<double> accumulated_mean;
+	std::vector<double> previous_accumulated_mean;
+};
@@ -0,0 +1,91 @@
+#include "WorkerPool.h"
+#include "GraphicsCortex.h"
+
+#include <algorithm>
+
+WorkerPool::WorkerPool(int32_t thread_count)
+{
+	if (thread_count <= 0) {
+		std::cout << "[FDTD Error] WorkerPool::WorkerPool() is called with invalid thread_count" << std::endl;
+		ASSERT(false);
+	}
+
+	for (int32_t i = 1; i < thread_count; i++)
+		workers.emplace_back(&WorkerPool::worker_loop, this);
+}
+
+WorkerPool::~WorkerPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	work_ready.notify_all();
+
+	for (std::thread& worker : workers)
+		worker.join();
+}
+
+void WorkerPool::run(int32_t task_count, const std::function<void(int32_t)>& task)
+{
+	if (workers.empty() || task_count <= 1) {
+		for (int32_t i = 0; i < task_count; i++)
+			task(i);
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		this->task = &task;
+		this->task_count = task_count;
+		next_task = 0;
+		busy_workers = (int32_t)workers.size();
+		generation++;
+	}
+	work_ready.notify_all();
+
+	execute_tasks();
+
+	std::unique_lock<std::mutex> lock(mutex);
+	work_done.wait(lock, [&]() { return busy_workers == 0; });
+	this->task = nullptr;
+}
+
+int32_t WorkerPool::get_thread_count()
+{
+	return (int32_t)workers.size() + 1;
+}
+
+int32_t WorkerPool::get_hardware_thread_count()
+{
+	return std::max(1, (int32_t)std::thread::hardware_concurrency());
+}
+
+void WorkerPool::worker_loop()
+{
+	uint64_t seen_generation = 0;
+
+	while (true) {
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			work_ready.wait(lock, [&]() { return stopping || generation != seen_generation; });
+			if (stopping)
+				return;
+			seen_generation = generation;
+		}
+
+		execute_tasks();
+
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			busy_workers--;
+		}
+		work_done.notify_one();
+	}
+}
+
+void WorkerPool::execute_tasks()
+{
+	for (int32_t i = next_task++; i < task_count; i = next_task++)
+		(*task)(i);
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// fixed set of threads that stay parked between runs so a sweep costs a wake up instead of a thread spawn.
+// run() hands out task indices through an atomic counter, the calling thread takes tasks as well and
+// returns once every task is finished.
+
+class WorkerPool {
+public:
+
+	// thread_count includes the calling thread, thread_count - 1 workers are spawned
+	WorkerPool(int32_t thread_count);
+	~WorkerPool();
+
+	WorkerPool(const WorkerPool&) = delete;
+	WorkerPool& operator=(const WorkerPool&) = delete;
+
+	void run(int32_t task_count, const std::function<void(int32_t)>& task);
+
+	int32_t get_thread_count();
+
+	// std::thread::hardware_concurrency(), at least 1
+	static int32_t get_hardware_thread_count();
+
+private:
+
+	void worker_loop();
+	void execute_tasks();
+
+	std::vector<std::thread> workers;
+
+	std::mutex mutex;
+	std::condition_variable work_ready;
+	std::condition_variable work_done;
+
+	const std::function<void(int32_t)>* task = nullptr;
+	int32_t task_count = 0;
+	std::atomic<int32_t> next_task{ 0 };
+
+	int32_t busy_workers = 0;
+	uint64_t generation = 0;
+	bool stopping = false;
+};
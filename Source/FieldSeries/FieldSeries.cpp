@@ -0,0 +1,502 @@
+#include "FieldSeries.h"
+#include "GraphicsCortex.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+// private copies of the stb zlib coders, the Mains that write PNGs compile their own stb_image_write
+#define STB_IMAGE_WRITE_STATIC
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#define STBI_WRITE_NO_STDIO
+#include "stb_image_write.h"
+
+#define STB_IMAGE_STATIC
+#define STB_IMAGE_IMPLEMENTATION
+#define STBI_ONLY_PNG
+#define STBI_NO_STDIO
+#include "stb_image.h"
+
+namespace {
+
+	constexpr char field_series_magic[4] = { 'G', 'Z', 'F', 'S' };
+	constexpr uint32_t field_series_version = 2;
+
+	// stb's default effort for PNGs
+	constexpr int32_t deflate_quality = 8;
+
+	enum FrameEncoding : uint8_t {
+		Intra			= 0,
+		DeltaKeyframe	= 1,
+	};
+
+	template<typename T>
+	void write_value(std::ostream& stream, const T& value) {
+		stream.write((const char*)&value, sizeof(T));
+	}
+
+	template<typename T>
+	void read_value(std::istream& stream, T& value) {
+		stream.read((char*)&value, sizeof(T));
+	}
+
+	uint32_t zigzag_encode(int32_t value) {
+		return (uint32_t(value) << 1) ^ uint32_t(value >> 31);
+	}
+
+	int32_t zigzag_decode(uint32_t value) {
+		return int32_t(value >> 1) ^ -int32_t(value & 1);
+	}
+
+	void write_varint(std::vector<uint8_t>& out, uint64_t value) {
+		while (value >= 0x80) {
+			out.push_back(uint8_t(value) | 0x80);
+			value >>= 7;
+		}
+		out.push_back(uint8_t(value));
+	}
+
+	bool read_varint(const uint8_t*& cursor, const uint8_t* end, uint64_t& value) {
+		value = 0;
+		for (int32_t shift = 0; cursor < end && shift < 64; shift += 7) {
+			uint8_t byte = *cursor++;
+			value |= uint64_t(byte & 0x7F) << shift;
+			if ((byte & 0x80) == 0)
+				return true;
+		}
+		return false;
+	}
+
+	// residuals are (frame - reference) minus its planar prediction from the left, upper and upper left
+	// neighbors, zigzag mapped. a token with low bit 1 is a run of zero residuals, with low bit 0 a single
+	// nonzero residual.
+	int32_t planar_prediction(const int32_t* values, size_t i, size_t row_width) {
+		size_t x = i % row_width;
+		int32_t left = x > 0 ? values[i - 1] : 0;
+		if (i < row_width)
+			return left;
+		int32_t up = values[i - row_width];
+		int32_t up_left = x > 0 ? values[i - row_width - 1] : up;
+		return left + up - up_left;
+	}
+
+	void encode_residuals(const int32_t* quantized, const int32_t* reference, size_t count, size_t row_width, std::vector<int32_t>& values, std::vector<uint8_t>& out) {
+
+		values.resize(count);
+		for (size_t i = 0; i < count; i++)
+			values[i] = quantized[i] - (reference != nullptr ? reference[i] : 0);
+
+		uint64_t zero_run = 0;
+
+		for (size_t i = 0; i < count; i++) {
+			uint32_t residual = zigzag_encode(values[i] - planar_prediction(values.data(), i, row_width));
+
+			if (residual == 0) {
+				zero_run++;
+				continue;
+			}
+
+			if (zero_run != 0) {
+				write_varint(out, (zero_run << 1) | 1);
+				zero_run = 0;
+			}
+			write_varint(out, uint64_t(residual) << 1);
+		}
+
+		if (zero_run != 0)
+			write_varint(out, (zero_run << 1) | 1);
+	}
+
+	bool decode_residuals(const uint8_t* cursor, const uint8_t* end, const int32_t* reference, size_t count, size_t row_width, int32_t* quantized) {
+
+		size_t i = 0;
+
+		while (i < count) {
+			uint64_t token;
+			if (!read_varint(cursor, end, token))
+				return false;
+
+			uint64_t repeat = 1;
+			int32_t residual = 0;
+
+			if (token & 1)
+				repeat = token >> 1;
+			else
+				residual = zigzag_decode(uint32_t(token >> 1));
+
+			if (repeat > count - i)
+				return false;
+
+			for (; repeat > 0; repeat--, i++)
+				quantized[i] = residual + planar_prediction(quantized, i, row_width);
+		}
+
+		if (reference != nullptr)
+			for (size_t i = 0; i < count; i++)
+				quantized[i] += reference[i];
+
+		return cursor == end;
+	}
+
+	// a frame is its encoding byte, the size of its residual tokens and the deflated tokens
+	void deflate_frame(FrameEncoding encoding, std::vector<uint8_t>& residual_bytes, std::vector<uint8_t>& out) {
+
+		int compressed_size = 0;
+		unsigned char* compressed = stbi_zlib_compress(residual_bytes.data(), (int)residual_bytes.size(), &compressed_size, deflate_quality);
+		uint32_t residual_size = (uint32_t)residual_bytes.size();
+
+		out.resize(1 + sizeof(residual_size) + compressed_size);
+		out[0] = encoding;
+		std::memcpy(out.data() + 1, &residual_size, sizeof(residual_size));
+		std::memcpy(out.data() + 1 + sizeof(residual_size), compressed, compressed_size);
+
+		STBIW_FREE(compressed);
+	}
+
+	bool inflate_frame(const std::vector<uint8_t>& frame, std::vector<uint8_t>& residual_bytes) {
+
+		uint32_t residual_size;
+		if (frame.size() < 1 + sizeof(residual_size))
+			return false;
+
+		std::memcpy(&residual_size, frame.data() + 1, sizeof(residual_size));
+		residual_bytes.resize(residual_size);
+
+		int inflated_size = stbi_zlib_decode_buffer((char*)residual_bytes.data(), (int)residual_size,
+			(const char*)frame.data() + 1 + sizeof(residual_size), (int)(frame.size() - 1 - sizeof(residual_size)));
+
+		return inflated_size == (int)residual_size;
+	}
+}
+
+FieldSeriesWriter::FieldSeriesWriter(const std::string& filepath, const Description& description) :
+	description(description)
+{
+	if (glm::any(glm::lessThanEqual(description.grid_resolution, glm::ivec3(0))) ||
+		glm::any(glm::lessThanEqual(description.decimation, glm::ivec3(0))) ||
+		glm::any(glm::lessThan(description.crop_begin, glm::ivec3(0))) ||
+		glm::any(glm::greaterThanEqual(description.crop_begin, description.grid_resolution)) ||
+		description.frames_per_chunk <= 0 ||
+		description.quantization_bits < 2 || description.quantization_bits > 24
+	) {
+		std::cout << "[FieldSeries Error] FieldSeriesWriter::FieldSeriesWriter() is called with invalid description" << std::endl;
+		ASSERT(false);
+	}
+
+	for (int32_t axis = 0; axis < 3; axis++) {
+		if (this->description.crop_size[axis] <= 0)
+			this->description.crop_size[axis] = description.grid_resolution[axis] - description.crop_begin[axis];
+		this->description.crop_size[axis] = std::min(this->description.crop_size[axis], description.grid_resolution[axis] - description.crop_begin[axis]);
+	}
+
+	frame_resolution = (this->description.crop_size + description.decimation - glm::ivec3(1)) / description.decimation;
+	frame_cell_count = (size_t)frame_resolution.x * frame_resolution.y * frame_resolution.z;
+	chunk_frames.resize(frame_cell_count * (description.value_scale > 0 ? 1 : description.frames_per_chunk));
+	keyframe.resize(frame_cell_count);
+	quantized.resize(frame_cell_count);
+
+	file.open(filepath, std::ios::binary | std::ios::trunc);
+	if (!file) {
+		std::cout << "[FieldSeries Error] FieldSeriesWriter::FieldSeriesWriter() cannot open " << filepath << std::endl;
+		ASSERT(false);
+	}
+
+	file.write(field_series_magic, sizeof(field_series_magic));
+	write_value(file, field_series_version);
+	write_value(file, description.grid_resolution);
+	write_value(file, description.crop_begin);
+	write_value(file, description.decimation);
+	write_value(file, frame_resolution);
+	write_value(file, description.time_per_frame);
+}
+
+FieldSeriesWriter::~FieldSeriesWriter()
+{
+	close();
+}
+
+void FieldSeriesWriter::append_frame(const float* grid_data)
+{
+	glm::ivec3 grid = description.grid_resolution;
+
+	append_frame([&](glm::ivec3 id) {
+		return grid_data[(size_t)id.z * grid.y * grid.x + (size_t)id.y * grid.x + id.x];
+		});
+}
+
+void FieldSeriesWriter::append_frame(std::function<float(glm::ivec3)> sampler)
+{
+	if (!file.is_open()) {
+		std::cout << "[FieldSeries Error] FieldSeriesWriter::append_frame() is called after close()" << std::endl;
+		ASSERT(false);
+	}
+
+	bool shared_scale = description.value_scale > 0;
+	float* frame = chunk_frames.data() + (shared_scale ? 0 : frame_cell_count * chunk_frame_count);
+
+	for (int32_t z = 0; z < frame_resolution.z; z++) {
+		for (int32_t y = 0; y < frame_resolution.y; y++) {
+			for (int32_t x = 0; x < frame_resolution.x; x++) {
+				glm::ivec3 id = description.crop_begin + glm::ivec3(x, y, z) * description.decimation;
+				*frame++ = sampler(id);
+			}
+		}
+	}
+
+	if (shared_scale)
+		encode_frame(chunk_frames.data(), chunk_frame_count, get_quantization_step(nullptr, 0));
+
+	chunk_frame_count++;
+	if (chunk_frame_count == description.frames_per_chunk)
+		flush_chunk();
+}
+
+// absolute step of a chunk, the shared value_scale or the largest |value| of the chunk's frames
+float FieldSeriesWriter::get_quantization_step(const float* frames, size_t cell_count)
+{
+	const int32_t quantization_max = (1 << (description.quantization_bits - 1)) - 1;
+
+	float value_scale = description.value_scale;
+	if (value_scale <= 0) {
+		for (size_t i = 0; i < cell_count; i++)
+			value_scale = std::max(value_scale, std::abs(frames[i]));
+	}
+
+	return value_scale > 0 ? value_scale / quantization_max : 1.0f;
+}
+
+// the first frame of a chunk is its keyframe, later ones are written intra or as a delta to it, whichever is smaller
+void FieldSeriesWriter::encode_frame(const float* frame, int32_t frame_in_chunk, float quantization_step)
+{
+	const int32_t quantization_max = (1 << (description.quantization_bits - 1)) - 1;
+	std::vector<int32_t>& target = frame_in_chunk == 0 ? keyframe : quantized;
+
+	for (size_t i = 0; i < frame_cell_count; i++) {
+		int32_t value = (int32_t)std::lround(frame[i] / quantization_step);
+		target[i] = std::clamp(value, -quantization_max, quantization_max);
+	}
+
+	residual_bytes.clear();
+	encode_residuals(target.data(), nullptr, frame_cell_count, frame_resolution.x, residual_buffer, residual_bytes);
+	deflate_frame(Intra, residual_bytes, intra_bytes);
+
+	std::vector<uint8_t>* chosen = &intra_bytes;
+
+	if (frame_in_chunk != 0) {
+		residual_bytes.clear();
+		encode_residuals(quantized.data(), keyframe.data(), frame_cell_count, frame_resolution.x, residual_buffer, residual_bytes);
+		deflate_frame(DeltaKeyframe, residual_bytes, delta_bytes);
+
+		if (delta_bytes.size() < intra_bytes.size())
+			chosen = &delta_bytes;
+	}
+
+	FrameRecord record;
+	record.offset = (uint64_t)file.tellp();
+	record.size = (uint32_t)chosen->size();
+	file.write((const char*)chosen->data(), chosen->size());
+
+	frame_records.push_back(record);
+}
+
+void FieldSeriesWriter::flush_chunk()
+{
+	if (chunk_frame_count == 0)
+		return;
+
+	ChunkRecord chunk;
+	chunk.frame_count = chunk_frame_count;
+
+	if (description.value_scale > 0) {
+		chunk.first_frame = (int32_t)frame_records.size() - chunk_frame_count;
+		chunk.quantization_step = get_quantization_step(nullptr, 0);
+	}
+	else {
+		chunk.first_frame = (int32_t)frame_records.size();
+		chunk.quantization_step = get_quantization_step(chunk_frames.data(), frame_cell_count * chunk_frame_count);
+
+		for (int32_t frame_index = 0; frame_index < chunk_frame_count; frame_index++)
+			encode_frame(chunk_frames.data() + frame_cell_count * frame_index, frame_index, chunk.quantization_step);
+	}
+
+	chunk_records.push_back(chunk);
+	chunk_frame_count = 0;
+}
+
+void FieldSeriesWriter::close()
+{
+	if (!file.is_open())
+		return;
+
+	flush_chunk();
+
+	uint64_t index_offset = (uint64_t)file.tellp();
+
+	write_value(file, (int32_t)chunk_records.size());
+	for (ChunkRecord& chunk : chunk_records) {
+		write_value(file, chunk.first_frame);
+		write_value(file, chunk.frame_count);
+		write_value(file, chunk.quantization_step);
+	}
+
+	write_value(file, (int32_t)frame_records.size());
+	for (FrameRecord& frame : frame_records) {
+		write_value(file, frame.offset);
+		write_value(file, frame.size);
+	}
+
+	write_value(file, index_offset);
+	file.close();
+}
+
+glm::ivec3 FieldSeriesWriter::get_frame_resolution()
+{
+	return frame_resolution;
+}
+
+int32_t FieldSeriesWriter::get_frame_count()
+{
+	bool shared_scale = description.value_scale > 0;
+	return (int32_t)frame_records.size() + (shared_scale ? 0 : chunk_frame_count);
+}
+
+FieldSeriesReader::FieldSeriesReader(const std::string& filepath)
+{
+	file.open(filepath, std::ios::binary);
+	if (!file) {
+		std::cout << "[FieldSeries Error] FieldSeriesReader::FieldSeriesReader() cannot open " << filepath << std::endl;
+		ASSERT(false);
+	}
+
+	char magic[4];
+	uint32_t version;
+	file.read(magic, sizeof(magic));
+	read_value(file, version);
+
+	if (!file || std::memcmp(magic, field_series_magic, sizeof(magic)) != 0 || version != field_series_version) {
+		std::cout << "[FieldSeries Error] FieldSeriesReader::FieldSeriesReader() " << filepath << " is not a field series" << std::endl;
+		ASSERT(false);
+	}
+
+	read_value(file, grid_resolution);
+	read_value(file, crop_begin);
+	read_value(file, decimation);
+	read_value(file, frame_resolution);
+	read_value(file, time_per_frame);
+	frame_cell_count = (size_t)frame_resolution.x * frame_resolution.y * frame_resolution.z;
+
+	uint64_t index_offset;
+	file.seekg(-(std::streamoff)sizeof(index_offset), std::ios::end);
+	read_value(file, index_offset);
+	file.seekg((std::streamoff)index_offset);
+
+	int32_t chunk_count;
+	read_value(file, chunk_count);
+	chunk_records.resize(std::max(chunk_count, 0));
+	for (ChunkRecord& chunk : chunk_records) {
+		read_value(file, chunk.first_frame);
+		read_value(file, chunk.frame_count);
+		read_value(file, chunk.quantization_step);
+	}
+
+	int32_t frame_count;
+	read_value(file, frame_count);
+	frame_records.resize(std::max(frame_count, 0));
+	for (FrameRecord& frame : frame_records) {
+		read_value(file, frame.offset);
+		read_value(file, frame.size);
+	}
+
+	for (int32_t chunk_index = 0; chunk_index < (int32_t)chunk_records.size(); chunk_index++) {
+		ChunkRecord& chunk = chunk_records[chunk_index];
+		for (int32_t i = 0; i < chunk.frame_count && chunk.first_frame + i < (int32_t)frame_records.size(); i++)
+			frame_records[chunk.first_frame + i].chunk = chunk_index;
+	}
+
+	if (!file) {
+		std::cout << "[FieldSeries Error] FieldSeriesReader::FieldSeriesReader() " << filepath << " has a corrupted index" << std::endl;
+		ASSERT(false);
+	}
+}
+
+void FieldSeriesReader::decode_quantized(int32_t frame_index, std::vector<int32_t>& quantized)
+{
+	FrameRecord& frame = frame_records[frame_index];
+	ChunkRecord& chunk = chunk_records[frame.chunk];
+
+	read_buffer.resize(frame.size);
+	file.seekg((std::streamoff)frame.offset);
+	file.read((char*)read_buffer.data(), frame.size);
+
+	const int32_t* reference = nullptr;
+	if (!read_buffer.empty() && read_buffer[0] == DeltaKeyframe) {
+		if (cached_keyframe_chunk != frame.chunk) {
+			decode_quantized(chunk.first_frame, cached_keyframe);
+			cached_keyframe_chunk = frame.chunk;
+
+			read_buffer.resize(frame.size);
+			file.seekg((std::streamoff)frame.offset);
+			file.read((char*)read_buffer.data(), frame.size);
+		}
+		reference = cached_keyframe.data();
+	}
+
+	quantized.resize(frame_cell_count);
+	if (!file || !inflate_frame(read_buffer, residual_bytes) ||
+		!decode_residuals(residual_bytes.data(), residual_bytes.data() + residual_bytes.size(), reference, frame_cell_count, frame_resolution.x, quantized.data())) {
+		std::cout << "[FieldSeries Error] FieldSeriesReader::read_frame() frame " << frame_index << " is corrupted" << std::endl;
+		ASSERT(false);
+	}
+}
+
+void FieldSeriesReader::read_frame(int32_t frame_index, float* target)
+{
+	if (frame_index < 0 || frame_index >= (int32_t)frame_records.size()) {
+		std::cout << "[FieldSeries Error] FieldSeriesReader::read_frame() is called with out of range frame_index" << std::endl;
+		ASSERT(false);
+	}
+
+	std::vector<int32_t> quantized;
+	decode_quantized(frame_index, quantized);
+
+	float quantization_step = chunk_records[frame_records[frame_index].chunk].quantization_step;
+	for (size_t i = 0; i < frame_cell_count; i++)
+		target[i] = quantized[i] * quantization_step;
+}
+
+std::vector<float> FieldSeriesReader::read_frame(int32_t frame_index)
+{
+	std::vector<float> frame(frame_cell_count);
+	read_frame(frame_index, frame.data());
+	return frame;
+}
+
+glm::ivec3 FieldSeriesReader::get_grid_resolution()
+{
+	return grid_resolution;
+}
+
+glm::ivec3 FieldSeriesReader::get_crop_begin()
+{
+	return crop_begin;
+}
+
+glm::ivec3 FieldSeriesReader::get_decimation()
+{
+	return decimation;
+}
+
+glm::ivec3 FieldSeriesReader::get_frame_resolution()
+{
+	return frame_resolution;
+}
+
+int32_t FieldSeriesReader::get_frame_count()
+{
+	return (int32_t)frame_records.size();
+}
+
+float FieldSeriesReader::get_frame_time(int32_t frame_index)
+{
+	return frame_index * time_per_frame;
+}
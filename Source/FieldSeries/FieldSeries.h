@@ -0,0 +1,128 @@
+#pragma once
+
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "glm.hpp"
+
+// single file container for field time series
+// frames are cropped/decimated, quantized per chunk with an absolute step so every frame
+// decodes back to physical values, and encoded either intra or as a delta to the chunk keyframe.
+// the predicted residuals are deflated with stb's zlib coder.
+// a trailing index lets the reader seek to any frame directly.
+// with a shared value_scale every frame is encoded as it is appended, otherwise a chunk of float
+// frames is buffered until its range is known.
+
+class FieldSeriesWriter {
+public:
+
+	struct Description {
+		glm::ivec3 grid_resolution = glm::ivec3(0);
+		glm::ivec3 crop_begin = glm::ivec3(0);
+		glm::ivec3 crop_size = glm::ivec3(0);		// 0 on an axis means until the end of the grid
+		glm::ivec3 decimation = glm::ivec3(1);
+		int32_t frames_per_chunk = 8;
+		int32_t quantization_bits = 12;
+		float value_scale = 0;						// shared |value| bound of the series, 0 derives it per chunk
+		float time_per_frame = 0;
+	};
+
+	FieldSeriesWriter(const std::string& filepath, const Description& description);
+	~FieldSeriesWriter();
+
+	// grid_data is the full grid, x fastest then y then z
+	void append_frame(const float* grid_data);
+	void append_frame(std::function<float(glm::ivec3)> sampler);
+
+	void close();
+
+	glm::ivec3 get_frame_resolution();
+	int32_t get_frame_count();
+
+private:
+
+	struct FrameRecord {
+		uint64_t offset = 0;
+		uint32_t size = 0;
+	};
+
+	struct ChunkRecord {
+		int32_t first_frame = 0;
+		int32_t frame_count = 0;
+		float quantization_step = 1;
+	};
+
+	void encode_frame(const float* frame, int32_t frame_in_chunk, float quantization_step);
+	void flush_chunk();
+	float get_quantization_step(const float* frames, size_t cell_count);
+
+	std::ofstream file;
+	Description description;
+	glm::ivec3 frame_resolution = glm::ivec3(0);
+	size_t frame_cell_count = 0;
+
+	std::vector<float> chunk_frames;			// one frame with a shared value_scale, frames_per_chunk otherwise
+	int32_t chunk_frame_count = 0;
+
+	std::vector<int32_t> keyframe;
+	std::vector<int32_t> quantized;
+	std::vector<int32_t> residual_buffer;
+	std::vector<uint8_t> residual_bytes;
+	std::vector<uint8_t> intra_bytes;
+	std::vector<uint8_t> delta_bytes;
+
+	std::vector<FrameRecord> frame_records;
+	std::vector<ChunkRecord> chunk_records;
+};
+
+class FieldSeriesReader {
+public:
+
+	FieldSeriesReader(const std::string& filepath);
+
+	void read_frame(int32_t frame_index, float* target);
+	std::vector<float> read_frame(int32_t frame_index);
+
+	glm::ivec3 get_grid_resolution();
+	glm::ivec3 get_crop_begin();
+	glm::ivec3 get_decimation();
+	glm::ivec3 get_frame_resolution();
+	int32_t get_frame_count();
+	float get_frame_time(int32_t frame_index);
+
+private:
+
+	struct FrameRecord {
+		uint64_t offset = 0;
+		uint32_t size = 0;
+		int32_t chunk = 0;
+	};
+
+	struct ChunkRecord {
+		int32_t first_frame = 0;
+		int32_t frame_count = 0;
+		float quantization_step = 1;
+	};
+
+	void decode_quantized(int32_t frame_index, std::vector<int32_t>& quantized);
+
+	std::ifstream file;
+
+	glm::ivec3 grid_resolution = glm::ivec3(0);
+	glm::ivec3 crop_begin = glm::ivec3(0);
+	glm::ivec3 decimation = glm::ivec3(1);
+	glm::ivec3 frame_resolution = glm::ivec3(0);
+	float time_per_frame = 0;
+	size_t frame_cell_count = 0;
+
+	std::vector<FrameRecord> frame_records;
+	std::vector<ChunkRecord> chunk_records;
+
+	int32_t cached_keyframe_chunk = -1;
+	std::vector<int32_t> cached_keyframe;
+	std::vector<uint8_t> read_buffer;
+	std::vector<uint8_t> residual_bytes;
+};
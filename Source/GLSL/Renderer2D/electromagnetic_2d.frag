@@ -9,14 +9,58 @@ in vec2 v_texcoord;
 layout(binding = 0) uniform sampler3D electric_texture;
 layout(binding = 1) uniform sampler3D magnetic_texture;
 layout(binding = 2) uniform sampler3D property_texture;
+layout(binding = 3) uniform sampler3D position_texture;  // (node position x, node position y) of the full grid, the axis lengths after the last nodes
 
 uniform vec3 texture_resolution;
 uniform int render_depth;
 
+uniform vec3 full_grid_resolution;
+uniform vec3 symmetry_origin;
+uniform vec3 symmetry_sign;     // 0 without a symmetry plane, 1 even, -1 odd
+uniform int graded_mesh;
+
+// full grid cell under a position in meters along an axis of a graded mesh, node i sits at the center of cell i
+float graded_cell(float position, int axis, int node_count) {
+    int first = 0;
+    int last = node_count - 1;
+
+    // last node at or before position
+    while (first < last) {
+        int middle = (first + last + 1) / 2;
+        if (texelFetch(position_texture, ivec3(middle, 0, 0), 0)[axis] <= position)
+            first = middle;
+        else
+            last = middle - 1;
+    }
+
+    float begin = texelFetch(position_texture, ivec3(first, 0, 0), 0)[axis];
+    float end = texelFetch(position_texture, ivec3(first + 1, 0, 0), 0)[axis];
+    return first + 0.5 + (position - begin) / (end - begin);
+}
+
 void main(){
-    float   electric = texture(electric_texture, vec3(v_texcoord, render_depth / texture_resolution.z + 0.5 / texture_resolution.z)).x;
-    vec2    magnetic = texture(magnetic_texture, vec3(v_texcoord, render_depth / texture_resolution.z + 0.5 / texture_resolution.z)).xy;
-    vec4    property = texture(property_texture, vec3(v_texcoord, render_depth / texture_resolution.z + 0.5 / texture_resolution.z));
+    // the screen spans the physical extent of the grid, on graded meshes cells are as wide as their spacing
+    vec2 cell = v_texcoord * full_grid_resolution.xy;
+    if (graded_mesh == 1) {
+        ivec2 node_count = ivec2(full_grid_resolution.xy);
+        vec2 axis_length = vec2(
+            texelFetch(position_texture, ivec3(node_count.x, 0, 0), 0).x,
+            texelFetch(position_texture, ivec3(node_count.y, 0, 0), 0).y
+        );
+        cell = vec2(graded_cell(v_texcoord.x * axis_length.x, 0, node_count.x), graded_cell(v_texcoord.y * axis_length.y, 1, node_count.y));
+    }
+
+    // the textures only hold the cells from the symmetry planes on, the rest of the grid is their mirror image
+    cell -= symmetry_origin.xy;
+    bvec2 mirrored = bvec2(symmetry_sign.x != 0 && cell.x < 0.5, symmetry_sign.y != 0 && cell.y < 0.5);
+    cell = mix(cell, 1.0 - cell, mirrored);
+
+    float electric_sign = (mirrored.x ? symmetry_sign.x : 1.0) * (mirrored.y ? symmetry_sign.y : 1.0);
+    vec2 texcoord = cell / texture_resolution.xy;
+
+    float   electric = texture(electric_texture, vec3(texcoord, render_depth / texture_resolution.z + 0.5 / texture_resolution.z)).x * electric_sign;
+    vec2    magnetic = texture(magnetic_texture, vec3(texcoord, render_depth / texture_resolution.z + 0.5 / texture_resolution.z)).xy;
+    vec4    property = texture(property_texture, vec3(texcoord, render_depth / texture_resolution.z + 0.5 / texture_resolution.z));
 
     const vec4 electric_color   = 1.2 * vec4(0.4, 0.69, 1, 1);
     const vec4 magnetic_color   = 1.2 * vec4(0.94, 0.49, 0.18, 1);